@@ -5,6 +5,8 @@ import sys
 import csv
 import datetime
 import string
+import struct
+import re
 
 from argparse import ArgumentParser
 from rich.console import Console
@@ -12,6 +14,24 @@ from rich.table import Table
 
 REG_MIN_VALUE = 0
 REG_MAX_VALUE = 0xFFFF
+REG_MAX_ADDR = 0xFFFE #registers number is 16-bit (bitmap helpers), so the last address can't be used
+
+#Register value types: words number, minimum and maximum values
+REG_TYPES = {'U16': (1, 0, 0xFFFF),
+             'I16': (1, -0x8000, 0x7FFF),
+             'U32': (2, 0, 0xFFFFFFFF),
+             'I32': (2, -0x80000000, 0x7FFFFFFF),
+             'F32': (2, -3.4e38, 3.4e38),
+             'U64': (4, 0, 0xFFFFFFFFFFFFFFFF)}
+
+#System registers block: name and comment. Read hooks are implemented by mb_sysregs.c
+SYS_REGS = [('SYS_UPTIME_H', 'Uptime, s (high word)'),
+            ('SYS_UPTIME_L', 'Uptime, s (low word)'),
+            ('SYS_REQ_RATE', 'Requests per second'),
+            ('SYS_TIME_AVG', 'Average response time, ms'),
+            ('SYS_TIME_MAX', 'Maximum response time, ms'),
+            ('SYS_CRC_RATE', 'CRC errors per 1000 frames'),
+            ('SYS_UPDQ_LEN', 'Registers updates queue depth')]
 
 #Converts string to int value
 def str_field2int(field):
@@ -24,6 +44,169 @@ def str_field2int(field):
         val = -1
     return val
 
+#Converts string to value of register type. Returns None on error
+def str_field2num(field, reg_type):
+    field = field.strip()
+    try:
+        if reg_type == 'F32':
+            return float(field)
+        if field.lower().startswith(('0x', '-0x')):
+            return int(field, 16)
+        return int(field)
+    except ValueError:
+        return None
+
+#Converts value of register type to C literal
+def c_literal(val, reg_type):
+    if reg_type.startswith('STR'):
+        return '"%s"'%(val.replace('\\', '\\\\').replace('"', '\\"'))
+    if reg_type == 'F32':
+        return "(%sf)"%(repr(float(val)))
+    if reg_type == 'U32':
+        return "%dUL"%(val)
+    if reg_type == 'U64':
+        return "%dULL"%(val)
+    if reg_type == 'I32' and val == -0x80000000:
+        return "(-2147483647L - 1)"
+    suffix = 'L' if reg_type == 'I32' else ''
+    return ("(%d%s)" if val < 0 else "%d%s")%(val, suffix)
+
+#Splits register default value to 16-bit words in registers order
+def reg_words(row):
+    size = row['Size']
+    if row['Type'].startswith('STR'):
+        data = row['Default'].encode('ascii', 'replace')[:2*size].ljust(2*size, b'\0')
+        return [(data[2*i] << 8) | data[2*i + 1] for i in range(size)]
+    if row['Type'] == 'F32':
+        raw = struct.unpack('>I', struct.pack('>f', row['Default']))[0]
+    else:
+        raw = row['Default'] & ((1 << (16*size)) - 1)
+    words = [(raw >> (16*(size - 1 - i))) & 0xFFFF for i in range(size)]
+    if row['Order'] == 'LSW':
+        words.reverse()
+    return words
+
+#Returns checked register mode
+def reg_mode(row, console):
+    if row['Mode'].upper() == 'R' or row['Mode'].upper() == 'W' or row['Mode'].upper() == 'RW' or row['Mode'].upper() == 'R/W':
+        return row['Mode'].upper()
+    console.print("[yellow]Warning: Mode of register \"%s\" is not correct. Set to R"%(row['Name']))
+    return 'R'
+
+#Accessor functions for register types
+REG_ACCESSORS = {'I16': ('((int16_t) MBRegGetValue(REG_%s_ADDR, err))', 'MBRegSetValue(REG_%s_ADDR, (uint16_t) (val), err)'),
+                 'U32': ('MBRegGetU32(REG_%s_ADDR, REG_%s_ORDER, err)', 'MBRegSetU32(REG_%s_ADDR, REG_%s_ORDER, val, err)'),
+                 'I32': ('((int32_t) MBRegGetU32(REG_%s_ADDR, REG_%s_ORDER, err))', 'MBRegSetU32(REG_%s_ADDR, REG_%s_ORDER, (uint32_t) (val), err)'),
+                 'F32': ('MBRegGetF32(REG_%s_ADDR, REG_%s_ORDER, err)', 'MBRegSetF32(REG_%s_ADDR, REG_%s_ORDER, val, err)'),
+                 'U64': ('MBRegGetU64(REG_%s_ADDR, REG_%s_ORDER, err)', 'MBRegSetU64(REG_%s_ADDR, REG_%s_ORDER, val, err)'),
+                 'STR': ('MBRegGetStr(REG_%s_ADDR, REG_%s_SIZE, str, err)', 'MBRegSetStr(REG_%s_ADDR, REG_%s_SIZE, str, err)')}
+
+#Binary register map format (see mb_regmap.h)
+BIN_MAGIC = 0x4D52424D
+BIN_VERSION = 1
+BIN_HDR = '<IHHIHHIIIHH'
+BIN_SEG_GAP = 8 #Gaps of at least this number of registers split segments
+
+#Modbus CRC16
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for i in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+#Returns binary register map image of registers table indexed by address
+def bin_map(reg_table, opts):
+    #contiguous segments, short gaps are kept as reserved registers
+    segs = []
+    for addr, row in enumerate(reg_table):
+        if row is None:
+            continue
+        if segs and addr - (segs[-1][0] + segs[-1][1]) < BIN_SEG_GAP:
+            segs[-1][1] = addr - segs[-1][0] + 1
+        else:
+            segs.append([addr, 1])
+    
+    seg_data = b''
+    opt_data = b''
+    def_data = b''
+    index = 0
+    for start, num in segs:
+        seg_data += struct.pack('<HHHH', start, num, index, 0)
+        for addr in range(start, start + num):
+            opt, min, max, default = opts[addr]
+            opt_data += struct.pack('<BBHH', opt, 0, min, max)
+            def_data += struct.pack('<H', default)
+        index += num
+    
+    align = lambda d: d + b'\0'*(-len(d) % 4)
+    hdr_size = struct.calcsize(BIN_HDR)
+    seg_off = hdr_size
+    opt_off = seg_off + len(align(seg_data))
+    def_off = opt_off + len(align(opt_data))
+    size = def_off + len(align(def_data))
+    hdr = struct.pack(BIN_HDR[:-1], BIN_MAGIC, BIN_VERSION, hdr_size, size, index, len(segs), seg_off, opt_off, def_off, 0)
+    #CRC bytes are stored in Modbus frame order (as MBRTU_CRC() returns)
+    hdr += struct.pack('>H', crc16(hdr))
+    return hdr + align(seg_data) + align(opt_data) + align(def_data)
+
+#Plans read requests covering wanted addresses (same algorithm as SiMasterPlanReads)
+def plan_reads(wanted, readable, gap):
+    plan = []
+    end = 0
+    for addr in sorted(set(wanted)):
+        if plan and addr - end <= gap and addr - plan[-1][0] < 125 and all(readable(a) for a in range(end, addr + 1)):
+            plan[-1][1] = addr - plan[-1][0] + 1
+        else:
+            plan.append([addr, 1])
+        end = addr + 1
+    return plan
+
+#C++ value types of registers
+REG_CPP_TYPES = {'U16':'uint16_t', 'I16':'int16_t', 'U32':'uint32_t', 'I32':'int32_t', 'F32':'float', 'U64':'uint64_t', 'STR':'const char *'}
+
+#Returns C++ constexpr descriptor of register
+def reg_cpp_desc(row):
+    reg_name = reg_c_name(row)
+    is_str = row['Type'].startswith('STR')
+    cpp_type = REG_CPP_TYPES['STR' if is_str else row['Type']]
+    if row['Type'] == 'U16':
+        geom = "1, REG_TYPE_U16, REG_ORDER_MSW"
+    else:
+        geom = "REG_%s_SIZE, REG_%s_TYPE, REG_%s_ORDER"%((reg_name,)*3)
+    lims = "nullptr, nullptr" if is_str else "REG_%s_MIN, REG_%s_MAX"%((reg_name,)*2)
+    hook = "MBRegCompute_%s"%(reg_name) if row['Age'] is not None else "nullptr"
+    desc = "/* %s */\r\n"%(row['Comment'])
+    desc += "inline constexpr Reg<%s> REG_%s{REG_%s_ADDR, %s, REG_%s_OPT, %s, REG_%s_DEF, %s};\r\n\r\n"%(cpp_type, \
+            reg_name, reg_name, geom, reg_name, lims, reg_name, hook)
+    return desc
+
+#Returns C definitions of typed register
+def typed_reg_defs(row, reg_name, oper_mode, tab_pos_ind, acc_tab_pos_ind):
+    reg_type = row['Type']
+    is_str = reg_type.startswith('STR')
+    
+    defs = "/* Register: %s\r\n* Addr: %s; Type: %s; Order: %s; Min: %s; Max: %s; Default: %s; Oper: %s */\r\n"%(row['Comment'], \
+            hex(row['Address']), reg_type, row['Order'], row['Min'], row['Max'], row['Default'], row['Mode'])
+    defs += tab2pos("#define REG_%s_ADDR"%(reg_name), "%s\r\n"%(hex(row['Address'])), tab_pos_ind)
+    if not is_str:
+        defs += tab2pos("#define REG_%s_MIN"%(reg_name), "%s\r\n"%(c_literal(row['Min'], reg_type)), tab_pos_ind)
+        defs += tab2pos("#define REG_%s_MAX"%(reg_name), "%s\r\n"%(c_literal(row['Max'], reg_type)), tab_pos_ind)
+    defs += tab2pos("#define REG_%s_DEF"%(reg_name), "%s\r\n"%(c_literal(row['Default'], reg_type)), tab_pos_ind)
+    defs += tab2pos("#define REG_%s_OPT"%(reg_name), "%s\r\n"%(oper_mode), tab_pos_ind)
+    defs += tab2pos("#define REG_%s_TYPE"%(reg_name), "REG_TYPE_%s\r\n"%('STR' if is_str else reg_type), tab_pos_ind)
+    defs += tab2pos("#define REG_%s_SIZE"%(reg_name), "%d\r\n"%(row['Size']), tab_pos_ind)
+    defs += tab2pos("#define REG_%s_ORDER"%(reg_name), "REG_ORDER_%s\r\n"%(row['Order']), tab_pos_ind)
+    
+    get_acc, set_acc = REG_ACCESSORS['STR' if is_str else reg_type]
+    names = (reg_name,)*get_acc.count('%s')
+    defs += tab2pos("#define REG_%s_GET(%s)"%(reg_name, 'str, err' if is_str else 'err'), "%s\r\n"%(get_acc%names), acc_tab_pos_ind)
+    names = (reg_name,)*set_acc.count('%s')
+    defs += tab2pos("#define REG_%s_SET(%s)"%(reg_name, 'str, err' if is_str else 'val, err'), "%s\r\n"%(set_acc%names), acc_tab_pos_ind)
+    defs += "\r\n"
+    return defs
+
 #Adds separation between str1 and str2 to aling str2 to pos
 def tab2pos(str1, str2, pos):
     out_str = str1;
@@ -32,6 +215,76 @@ def tab2pos(str1, str2, pos):
     out_str += str2;
     return out_str;
 
+#Returns register name in C definitions format
+def reg_c_name(row):
+    return row['Name'].upper().replace(' ','_')
+
+#Packs registers table to 32-bit words bitmap. Bit is set if check(register) is True
+def bitmap_words(reg_table, check):
+    words = [0]*((len(reg_table) + 31)//32)
+    for addr, row in enumerate(reg_table):
+        if check(row):
+            words[addr//32] |= 1 << (addr % 32)
+    return words
+
+#Converts bitmap words to C array initializer
+def bitmap2str(words):
+    return ",\r\n".join(["\t0x%08X"%(w) for w in words])
+
+#Reads coils or discrete inputs csv file (Name, Address, Mode, Default, Comment).
+#Returns points list sorted by address
+def read_bits_file(filename, kind, console):
+    points = []
+    with open(filename, newline='') as csvfile:
+        reader = csv.DictReader(csvfile)
+        try:
+            for row in reader:
+                if row['Name'].upper() == 'RESERVED':
+                    continue
+                
+                addr = str_field2int(row['Address'])
+                if addr < REG_MIN_VALUE or addr > REG_MAX_VALUE:
+                    console.print("[yellow]Warning: Address of %s \"%s\" is not correct. Skip"%(kind, row['Name']))
+                    continue
+                
+                if any(p['Address'] == addr for p in points):
+                    console.print("[yellow]Warning: Address of %s \"%s\" is already used. Skip"%(kind, row['Name']))
+                    continue
+                
+                default = str_field2int(row.get('Default') or '0')
+                if default != 0 and default != 1:
+                    default = 0
+                    console.print("[yellow]Warning: Default value of %s \"%s\" is not correct. Set to 0"%(kind, row['Name']))
+                
+                #discrete inputs are read only
+                mode = (row.get('Mode') or 'R').strip().upper()
+                write = kind == 'coil' and mode != 'R'
+                
+                points.append({'Address':addr, 'Name':row['Name'], 'Comment':row.get('Comment') or '', 'Default':default, 'Write':write})
+        except csv.Error as e:
+            sys.exit('file {}, line {}: {}'.format(filename, reader.line_num, e))
+    
+    return sorted(points, key=lambda k: k['Address'])
+
+#Returns C definitions of coils or discrete inputs
+def bits_defs(points, prefix, kind):
+    defs = ""
+    tab_pos_ind = 4*((max([len(p['Name']) for p in points] + [0]) + 18 + 3)//4) + 4
+    for p in points:
+        name = reg_c_name(p)
+        defs += "/* %s: %s\r\n* Addr: %s; Default: %d; Oper: %s */\r\n"%(kind, p['Comment'], hex(p['Address']), p['Default'], 'RW' if p['Write'] else 'R')
+        defs += tab2pos("#define %s_%s_ADDR"%(prefix, name), "%s\r\n"%(hex(p['Address'])), tab_pos_ind)
+        defs += tab2pos("#define %s_%s_DEF"%(prefix, name), "%d\r\n"%(p['Default']), tab_pos_ind)
+        defs += "\r\n"
+    return defs
+
+#Packs points to 32-bit words bitmap (at least one word). Bit is set if check(point) is True
+def bits2words(points, num, check):
+    table = [None]*num
+    for p in points:
+        table[p['Address']] = p
+    return bitmap_words(table, lambda p: p is not None and check(p)) or [0]
+
 def main(argv=None): # IGNORE:C0111
     '''Command line options.'''
 
@@ -44,6 +297,12 @@ def main(argv=None): # IGNORE:C0111
         # Setup argument parser
         parser = ArgumentParser(description="Register map generator.")
         parser.add_argument('-p', '--python', dest='python', action='store_true', help='Python file generation.')
+        parser.add_argument('--plan', dest='plan', type=int, metavar='GAP', help='Master read plan generation with GAP registers tolerance.')
+        parser.add_argument('-b', '--bin', dest='bin', action='store_true', help='Binary register map generation.')
+        parser.add_argument('--cpp', dest='cpp', action='store_true', help='C++17 constexpr header generation.')
+        parser.add_argument('--sys', dest='sys', type=lambda x: int(x, 0), metavar='ADDR', help='System registers block at ADDR.')
+        parser.add_argument('-c', '--coils', dest='coils', help='Coils .csv file.')
+        parser.add_argument('-i', '--inputs', dest='inputs', help='Discrete inputs .csv file.')
         parser.add_argument("file", help=".csv input file")
 
         # Process arguments
@@ -75,9 +334,83 @@ def main(argv=None): # IGNORE:C0111
                     continue
                 
                 addr = str_field2int(row['Address'])
-                if addr < REG_MIN_VALUE or addr > REG_MAX_VALUE:
+                if addr < REG_MIN_VALUE or addr > REG_MAX_ADDR:
                     addr = 0
                     console.print("[yellow]Warning: Address of register \"%s\" is not correct. Set to 0"%(row['Name']))
+                
+                #Value type and words order of multi-register values
+                reg_type = (row.get('Type') or 'U16').strip().upper()
+                str_type = re.fullmatch(r'STR(\d+)', reg_type)
+                if str_type and int(str_type.group(1)) > 0:
+                    size = (int(str_type.group(1)) + 1)//2
+                elif reg_type in REG_TYPES:
+                    size = REG_TYPES[reg_type][0]
+                else:
+                    reg_type = 'U16'
+                    size = 1
+                    console.print("[yellow]Warning: Type of register \"%s\" is not correct. Set to U16"%(row['Name']))
+                
+                order = (row.get('Order') or 'MSW').strip().upper()
+                if order != 'MSW' and order != 'LSW':
+                    order = 'MSW'
+                    console.print("[yellow]Warning: Words order of register \"%s\" is not correct. Set to MSW"%(row['Name']))
+                
+                #stored by non-volatile journal
+                nv = (row.get('NV') or '').strip().upper() in ('Y', 'YES', '1')
+                
+                #computed register: read hook memoization age in ms (Y - compute on every read)
+                age = (row.get('Compute') or '').strip().upper()
+                if age == '':
+                    age = None
+                elif age == 'Y' or age == 'YES':
+                    age = 0
+                else:
+                    age = str_field2int(age)
+                    if age < REG_MIN_VALUE or age > REG_MAX_VALUE:
+                        age = 0
+                        console.print("[yellow]Warning: Compute age of register \"%s\" is not correct. Set to 0"%(row['Name']))
+                
+                if age is not None and reg_type != 'U16':
+                    age = None
+                    console.print("[yellow]Warning: Typed register \"%s\" can't be computed"%(row['Name']))
+                
+                if addr + size - 1 > REG_MAX_ADDR:
+                    console.print("[yellow]Warning: Register \"%s\" is out of address space. Skip"%(row['Name']))
+                    continue
+                
+                if reg_type != 'U16':
+                    if str_type:
+                        min = 0
+                        max = 0
+                        default = row['Default']
+                    else:
+                        type_min = REG_TYPES[reg_type][1]
+                        type_max = REG_TYPES[reg_type][2]
+                        
+                        min = str_field2num(row['Min'], reg_type)
+                        if min is None or min < type_min or min > type_max:
+                            min = type_min
+                            console.print("[yellow]Warning: Minimum value of register \"%s\" is not correct. Set to %s"%(row['Name'], min))
+                        
+                        max = str_field2num(row['Max'], reg_type)
+                        if max is None or max < type_min or max > type_max:
+                            max = type_max
+                            console.print("[yellow]Warning: Maximum value of register \"%s\" is not correct. Set to %s"%(row['Name'], max))
+                        
+                        default = str_field2num(row['Default'], reg_type)
+                        if default is None or default < type_min or default > type_max:
+                            default = 0
+                            console.print("[yellow]Warning: Default value of register \"%s\" is not correct. Set to 0"%(row['Name']))
+                    
+                    reg_map.append({'Address':addr, 'Min':min, 'Max':max, 'Default':default, 'Mode':reg_mode(row, console), \
+                                    'Name':row['Name'], 'Comment':row['Comment'], 'Type':reg_type, 'Size':size, 'Order':order, 'NV':nv, 'Age':None})
+                    
+                    if addr + size - 1 > last_reg_addr:
+                        last_reg_addr = addr + size - 1
+                    
+                    if len(row['Name']) > max_name_len:
+                        max_name_len = len(row['Name'])
+                    continue
                     
                 min = str_field2int(row['Min'])
                 if min < REG_MIN_VALUE or min > REG_MAX_VALUE:
@@ -97,13 +430,14 @@ def main(argv=None): # IGNORE:C0111
                     default = 0
                     console.print("[yellow]Warning: Default value of register \"%s\" is not correct. Set to 0"%(row['Name']))
                     
-                if row['Mode'].upper() == 'R' or row['Mode'].upper() == 'W' or row['Mode'].upper() == 'RW' or row['Mode'].upper() == 'R/W':
-                    oper = row['Mode'].upper()
-                else:
+                oper = reg_mode(row, console)
+                
+                if age is not None and oper != 'R':
                     oper = 'R'
-                    console.print("[yellow]Warning: Mode of register \"%s\" is not correct. Set to R"%(row['Name']))
+                    console.print("[yellow]Warning: Computed register \"%s\" is read only. Set mode to R"%(row['Name']))
          
-                reg_map.append({'Address':addr, 'Min':min, 'Max':max, 'Default':default, 'Mode':oper, 'Name':row['Name'], 'Comment':row['Comment']})
+                reg_map.append({'Address':addr, 'Min':min, 'Max':max, 'Default':default, 'Mode':oper, 'Name':row['Name'], 'Comment':row['Comment'], \
+                                'Type':'U16', 'Size':1, 'Order':'MSW', 'NV':nv, 'Age':age})
                 
                 if addr > last_reg_addr:
                     last_reg_addr = addr
@@ -113,12 +447,43 @@ def main(argv=None): # IGNORE:C0111
 
         except csv.Error as e:
             sys.exit('file {}, line {}: {}'.format(filename, reader.line_num, e))
+        
+        '''System registers block'''
+        if args.sys is not None:
+            if args.sys < REG_MIN_VALUE or args.sys + len(SYS_REGS) - 1 > REG_MAX_ADDR:
+                sys.exit('System registers block is out of address space')
+            
+            #read hooks of the whole block are implemented by mb_sysregs.c, so no register can be skipped
+            for row in reg_map:
+                if row['Address'] < args.sys + len(SYS_REGS) and row['Address'] + row['Size'] > args.sys:
+                    sys.exit('System registers block overlaps register "%s"'%(row['Name']))
+            
+            for i, (name, comment) in enumerate(SYS_REGS):
+                reg_map.append({'Address':args.sys + i, 'Min':0, 'Max':0xFFFF, 'Default':0, 'Mode':'R', 'Name':name, 'Comment':comment, \
+                                'Type':'U16', 'Size':1, 'Order':'MSW', 'NV':False, 'Age':0, 'Sys':True})
+                
+                if args.sys + i > last_reg_addr:
+                    last_reg_addr = args.sys + i
+                
+                if len(name) > max_name_len:
+                    max_name_len = len(name)
             
         console.print("Last Address: %s"%(hex(last_reg_addr)))
         reg_num = last_reg_addr + 1
         console.print("Registers number: %s"%(reg_num))
         
         reg_map = sorted(reg_map, key=lambda k: k['Address'])
+        
+        #multi-register values must not overlap
+        checked_map = []
+        for row in reg_map:
+            if checked_map and row['Address'] < checked_map[-1]['Address'] + checked_map[-1]['Size']:
+                console.print("[yellow]Warning: Register \"%s\" overlaps register \"%s\". Skip"%(row['Name'], checked_map[-1]['Name']))
+                continue
+            checked_map.append(row)
+        reg_map = checked_map
+        typed_map = [row for row in reg_map if row['Type'] != 'U16']
+        computed_map = [row for row in reg_map if row['Age'] is not None]
 
         '''Create Table'''
         table = Table(title="[bold]Registers map")
@@ -129,13 +494,22 @@ def main(argv=None): # IGNORE:C0111
         table.add_column("Max")
         table.add_column("Default")
         table.add_column("Mode")
+        table.add_column("Type")
 
         for row in reg_map:
             #Fill Console table
-            table.add_row(hex(row['Address']), row['Name'], str(row['Min']), str(row['Max']), str(row['Default']), row['Mode'])
+            table.add_row(hex(row['Address']), row['Name'], str(row['Min']), str(row['Max']), str(row['Default']), row['Mode'], row['Type'])
 
         console.print(table)
         
+        '''Coils and discrete inputs'''
+        coils = read_bits_file(args.coils, 'coil', console) if args.coils else []
+        coil_num = coils[-1]['Address'] + 1 if coils else 0
+        console.print("Coils number: %s"%(coil_num))
+        dinps = read_bits_file(args.inputs, 'input', console) if args.inputs else []
+        dinp_num = dinps[-1]['Address'] + 1 if dinps else 0
+        console.print("Discrete inputs number: %s"%(dinp_num))
+        
         '''Create C files'''
             
         '''Register map'''
@@ -148,6 +522,8 @@ def main(argv=None): # IGNORE:C0111
         reg_map_defs = ""
         #get closest tab position index
         tab_pos_ind = 4*((max_name_len+ 17 + 3)//4) + 4
+        #typed values accessors are longer
+        acc_tab_pos_ind = 4*((max_name_len+ 27 + 3)//4) + 4
         
         for row in reg_map:
             reg_name = row['Name'].upper()
@@ -168,6 +544,10 @@ def main(argv=None): # IGNORE:C0111
                 oper_mode = 'REG_OPT_WR_ONLY'
             elif oper == 'RW' or oper == 'R/W':
                 oper_mode = 'REG_OPT_ALL'
+            
+            if row['Type'] != 'U16':
+                reg_map_defs += typed_reg_defs(row, reg_name, oper_mode, tab_pos_ind, acc_tab_pos_ind)
+                continue
                 
             reg_map_defs += "/* Register: %s\r\n* Addr: %s; Min: %d; Max: %d; Default: %d; Oper: %s */\r\n"%(row['Comment'], hex(addr), min, max, default, oper)
             reg_map_defs += tab2pos("#define REG_%s_ADDR"%(reg_name), "%s\r\n"%(hex(addr)), tab_pos_ind)
@@ -175,13 +555,22 @@ def main(argv=None): # IGNORE:C0111
             reg_map_defs += tab2pos("#define REG_%s_MAX"%(reg_name), "%s\r\n"%(max), tab_pos_ind)
             reg_map_defs += tab2pos("#define REG_%s_DEF"%(reg_name), "%s\r\n"%(default), tab_pos_ind)
             reg_map_defs += tab2pos("#define REG_%s_OPT"%(reg_name), "%s\r\n"%(oper_mode), tab_pos_ind)
+            if row['Age'] is not None:
+                reg_map_defs += tab2pos("#define REG_%s_AGE"%(reg_name), "%d\r\n"%(row['Age']), tab_pos_ind)
             reg_map_defs += "\r\n"
         
         #fill template and write to file
         rmh_content = rmh_template.safe_substitute(date=datetime.date.today(), \
                                                    register_map = reg_map_defs, \
                                                    reg_last_addr = hex(last_reg_addr), \
-                                                   reg_num = reg_num)
+                                                   reg_num = reg_num, \
+                                                   typed_num = len(typed_map), \
+                                                   computed_num = len(computed_map), \
+                                                   compute_protos = "".join(["uint16_t MBRegCompute_%s(void);\r\n"%(reg_c_name(row)) for row in computed_map]), \
+                                                   coil_map = bits_defs(coils, 'COIL', 'Coil'), \
+                                                   coil_num = coil_num, \
+                                                   dinp_map = bits_defs(dinps, 'DINP', 'Input'), \
+                                                   dinp_num = dinp_num)
         rmh_f.write(rmh_content)
         
         console.print("[green]File mb_regs.h is created")
@@ -195,47 +584,143 @@ def main(argv=None): # IGNORE:C0111
 
         #static variables
         
+        #registers table indexed by address. Gaps are filled with reserved registers
+        reg_table = [None]*reg_num
+        for row in reg_map:
+            for i in range(row['Size']):
+                reg_table[row['Address'] + i] = row
+        
         #fill geristers options array
         reg_opts_vals = ""
-        for row in reg_map:
-            reg_name = row['Name'].upper()
-            reg_name = reg_name.replace(' ','_')
-            
-            reg_opt_str = ''
-            
-            if reg_name == 'RESERVED':
-                reg_opt_str += "\t{REG_OPT_R_ONLY, 0, 0, 0}"
+        for addr, row in enumerate(reg_table):
+            if row is None:
+                reg_opts_vals += "\t{REG_OPT_R_ONLY, 0, 0, 0}"
+            elif row['Type'] != 'U16':
+                #typed values restrictions are checked with typed values table
+                reg_opts_vals += "\t{REG_%s_OPT, 0, 0xFFFF, 0x%04X}"%(reg_c_name(row), reg_words(row)[addr - row['Address']])
             else:
-                reg_opt_str += \
+                reg_name = reg_c_name(row)
+                reg_opts_vals += \
                 "\t{REG_%s_OPT, REG_%s_MIN, REG_%s_MAX, REG_%s_DEF}"%(reg_name, \
                                                                       reg_name, \
                                                                       reg_name, \
                                                                       reg_name)
-            if row != reg_map[-1]:
-                reg_opt_str += ",\r\n"
-            
-            reg_opts_vals += reg_opt_str
+            if addr != reg_num - 1:
+                reg_opts_vals += ",\r\n"
         
         #fill geristers values array
         reg_def_vals = ""
-        for row in reg_map:
-            reg_name = row['Name'].upper()
-            reg_name = reg_name.replace(' ','_')
-            
-            if reg_name == 'RESERVED':
+        for addr, row in enumerate(reg_table):
+            if row is None:
                 reg_def_vals += "\t0"
+            elif row['Type'] != 'U16':
+                reg_def_vals += "\t0x%04X"%(reg_words(row)[addr - row['Address']])
             else:
-                reg_def_vals += "\tREG_%s_DEF"%(reg_name)
-            if row != reg_map[-1]:
+                reg_def_vals += "\tREG_%s_DEF"%(reg_c_name(row))
+            if addr != reg_num - 1:
                 reg_def_vals += ",\r\n"
+        
+        #permission and value restriction bitmaps
+        rd_map = bitmap_words(reg_table, lambda r: r is None or r['Mode'] != 'W')
+        wr_map = bitmap_words(reg_table, lambda r: r is not None and r['Mode'] != 'R')
+        nolim_map = bitmap_words(reg_table, lambda r: r is not None and (r['Type'] != 'U16' or \
+                                 (r['Min'] == REG_MIN_VALUE and r['Max'] == REG_MAX_VALUE)))
+        typed_bitmap = bitmap_words(reg_table, lambda r: r is not None and r['Type'] != 'U16')
+        nv_map = bitmap_words(reg_table, lambda r: r is not None and r['NV'])
+        computed_bitmap = bitmap_words(reg_table, lambda r: r is not None and r['Age'] is not None)
+        
+        #computed registers table and read hooks
+        computed_vals = []
+        compute_hooks = ""
+        for row in computed_map:
+            reg_name = reg_c_name(row)
+            computed_vals.append("\t{REG_%s_ADDR, REG_%s_AGE, MBRegCompute_%s}"%((reg_name,)*3))
+            if row.get('Sys'):
+                continue
+            compute_hooks += "/**\r\n * @brief Read hook of computed register: %s\r\n * @return Register value\r\n */\r\n"%(row['Comment'])
+            compute_hooks += "__weak uint16_t MBRegCompute_%s(void)\r\n{\r\n\t/* USER CODE BEGIN */\r\n\treturn REG_%s_DEF;\r\n\t/* USER CODE END */\r\n}\r\n\r\n"%(reg_name, reg_name)
+        
+        #fill typed values table
+        typed_vals = []
+        for row in typed_map:
+            reg_name = reg_c_name(row)
+            if row['Type'].startswith('STR'):
+                typed_vals.append("\t{REG_%s_ADDR, REG_%s_SIZE, REG_%s_TYPE, REG_%s_ORDER, {.u = 0}, {.u = 0}}"%((reg_name,)*4))
+            else:
+                lim = {'I16':'i', 'I32':'i', 'F32':'f'}.get(row['Type'], 'u')
+                typed_vals.append("\t{REG_%s_ADDR, REG_%s_SIZE, REG_%s_TYPE, REG_%s_ORDER, {.%s = REG_%s_MIN}, {.%s = REG_%s_MAX}}"%(\
+                                  reg_name, reg_name, reg_name, reg_name, lim, reg_name, lim, reg_name))
          
         #fill template and write to file
         mbr_content = mbr_template.safe_substitute(date=datetime.date.today(), \
                                                    opt_vals = reg_opts_vals, \
-                                                   def_vals = reg_def_vals)
+                                                   def_vals = reg_def_vals, \
+                                                   rd_map = bitmap2str(rd_map), \
+                                                   wr_map = bitmap2str(wr_map), \
+                                                   nolim_map = bitmap2str(nolim_map), \
+                                                   typed_vals = ",\r\n".join(typed_vals), \
+                                                   typed_map = bitmap2str(typed_bitmap), \
+                                                   nv_map = bitmap2str(nv_map), \
+                                                   computed_vals = ",\r\n".join(computed_vals), \
+                                                   computed_map = bitmap2str(computed_bitmap), \
+                                                   compute_hooks = compute_hooks, \
+                                                   coil_def = bitmap2str(bits2words(coils, coil_num, lambda p: p['Default'])), \
+                                                   coil_wr_map = bitmap2str(bits2words(coils, coil_num, lambda p: p['Write'])), \
+                                                   dinp_def = bitmap2str(bits2words(dinps, dinp_num, lambda p: p['Default'])))
         mbr_f.write(mbr_content)
         
         console.print("[green]File mb_regs.c is created")
+        
+        ''' Generate master read plan '''
+        if args.plan is not None:
+            #reserved registers are readable, write only registers are holes
+            readable = lambda a: reg_table[a] is None or reg_table[a]['Mode'] != 'W'
+            wanted = [a for a in range(reg_num) if reg_table[a] is not None and readable(a)]
+            plan_gap = args.plan if args.plan > 0 else 0
+            plan = plan_reads(wanted, readable, plan_gap)
+            
+            with open("mb_regs_plan_h.template") as ht:
+                plan_template = string.Template(ht.read())
+            
+            plan_f = open('mb_regs_plan.h', 'w', newline='')
+            plan_f.write(plan_template.safe_substitute(date=datetime.date.today(), \
+                                                       plan_gap = plan_gap, \
+                                                       plan_num = len(plan), \
+                                                       plan_vals = ", \\\r\n".join(["\t{%s, %d}"%(hex(a), n) for a, n in plan])))
+            
+            console.print("[green]File mb_regs_plan.h is created. Read requests: %d"%(len(plan)))
+        
+        ''' Generate binary register map '''
+        if args.bin == True:
+            #same options as generated registers options array
+            opt_codes = {'R':0x05, 'W':0x0A, 'RW':0x0F, 'R/W':0x0F}
+            opts = []
+            for addr, row in enumerate(reg_table):
+                if row is None:
+                    opts.append((0x05, 0, 0, 0))
+                elif row['Type'] != 'U16':
+                    opts.append((opt_codes[row['Mode']], 0, 0xFFFF, reg_words(row)[addr - row['Address']]))
+                else:
+                    opts.append((opt_codes[row['Mode']], row['Min'], row['Max'], row['Default']))
+            
+            with open('mb_regs.bin', 'wb') as bin_f:
+                bin_f.write(bin_map(reg_table, opts))
+            
+            console.print("[green]File mb_regs.bin is created")
+        
+        ''' Generate C++ header '''
+        if args.cpp == True:
+            with open("mb_regs_hpp.template") as ht:
+                hpp_template = string.Template(ht.read())
+            
+            reg_opts = ",\r\n".join(["\tREG_OPT_R_ONLY" if row is None else "\tREG_%s_OPT"%(reg_c_name(row)) for row in reg_table])
+            
+            hpp_f = open('mb_regs.hpp', 'w', newline='')
+            hpp_f.write(hpp_template.safe_substitute(date=datetime.date.today(), \
+                                                     reg_descs = "".join([reg_cpp_desc(row) for row in reg_map]), \
+                                                     reg_opts = reg_opts))
+            
+            console.print("[green]File mb_regs.hpp is created")
 
         """ Generate python file """
         if args.python == True:
@@ -269,12 +754,16 @@ def main(argv=None): # IGNORE:C0111
                 elif oper == 'RW' or oper == 'R/W':
                     oper_mode = 'REG_OPT_ALL'
                     
-                reg_map_defs += "\"\"\" Register: %s\r\n Addr: %s; Min: %d; Max: %d; Default: %d; Oper: %s \"\"\"\r\n"%(row['Comment'], hex(addr), min, max, default, oper)
+                reg_map_defs += "\"\"\" Register: %s\r\n Addr: %s; Min: %s; Max: %s; Default: %s; Oper: %s \"\"\"\r\n"%(row['Comment'], hex(addr), min, max, default, oper)
                 reg_map_defs += tab2pos("REG_%s_ADDR"%(reg_name), " = %s\r\n"%(hex(addr)), tab_pos_ind)
                 reg_map_defs += tab2pos("REG_%s_MIN"%(reg_name), " = %s\r\n"%(min), tab_pos_ind)
                 reg_map_defs += tab2pos("REG_%s_MAX"%(reg_name), " = %s\r\n"%(max), tab_pos_ind)
-                reg_map_defs += tab2pos("REG_%s_DEF"%(reg_name), " = %s\r\n"%(default), tab_pos_ind)
+                reg_map_defs += tab2pos("REG_%s_DEF"%(reg_name), " = %s\r\n"%(repr(default)), tab_pos_ind)
                 reg_map_defs += tab2pos("REG_%s_OPT"%(reg_name), " = %s\r\n"%(oper_mode), tab_pos_ind)
+                if row['Type'] != 'U16':
+                    reg_map_defs += tab2pos("REG_%s_TYPE"%(reg_name), " = '%s'\r\n"%(row['Type']), tab_pos_ind)
+                    reg_map_defs += tab2pos("REG_%s_SIZE"%(reg_name), " = %d\r\n"%(row['Size']), tab_pos_ind)
+                    reg_map_defs += tab2pos("REG_%s_ORDER"%(reg_name), " = '%s'\r\n"%(row['Order']), tab_pos_ind)
                 reg_map_defs += "\r\n"
             
             #fill template and write to file
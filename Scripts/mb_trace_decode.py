@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+
+import sys
+import struct
+from argparse import ArgumentParser
+from rich.console import Console
+from rich.table import Table
+
+#MBTraceRec_t: time, addr, num, port, event, func, err (little endian)
+REC_FORMAT = '<IHHBBBB'
+REC_SIZE = struct.calcsize(REC_FORMAT)
+
+#MBTrace_t header: head, port and padding
+HDR_FORMAT = '<IB3x'
+HDR_SIZE = struct.calcsize(HDR_FORMAT)
+
+EVENTS = {1: 'REQ', 2: 'RESP', 3: 'CRC', 4: 'DROP', 5: 'CONN'}
+
+#Reads records copied by MBTraceRead()
+def read_records(data):
+    return [struct.unpack_from(REC_FORMAT, data, i) for i in range(0, len(data) - REC_SIZE + 1, REC_SIZE)]
+
+#Reads memory image of MBTrace_t with rec_num records and orders records oldest first
+def read_raw(data, rec_num):
+    head, port = struct.unpack_from(HDR_FORMAT, data, 0)
+    ring = read_records(data[HDR_SIZE:HDR_SIZE + rec_num*REC_SIZE])
+
+    if len(ring) != rec_num:
+        raise ValueError('Image is shorter than %d records'%(rec_num))
+
+    num = head if head < rec_num else rec_num
+    return [ring[i % rec_num] for i in range(head - num, head)]
+
+def trace_table(records, tick_us, slow_us) -> Table:
+    table = Table()
+
+    table.add_column("Time, us", style="cyan", no_wrap=True)
+    table.add_column("Delta, us")
+    table.add_column("Port")
+    table.add_column("Event", style="green")
+    table.add_column("Func")
+    table.add_column("Address")
+    table.add_column("Count")
+    table.add_column("Error")
+    table.add_column("Latency, us")
+
+    prev = None
+    req_time = {}
+
+    for time, addr, num, port, event, func, err in records:
+        delta = ((time - prev) & 0xFFFFFFFF)*tick_us if prev is not None else 0
+        prev = time
+        latency = ''
+        style = None
+
+        #response latency from request of the same port
+        if event == 1:
+            req_time[port] = time
+        elif event == 2 and port in req_time:
+            lat = ((time - req_time.pop(port)) & 0xFFFFFFFF)*tick_us
+            latency = str(lat)
+            if slow_us is not None and lat >= slow_us:
+                style = "bold red"
+
+        if event == 1:
+            addr_str, num_str = str(addr), str(num)
+        else:
+            addr_str, num_str = '', str(num) if event != 5 else ''
+
+        table.add_row(str(time*tick_us), str(delta), str(port), EVENTS.get(event, str(event)), str(func) if func else '', \
+                      addr_str, num_str, str(err) if err else '', latency, style=style)
+
+    return table
+
+def main(argv=None):
+    if argv is None:
+        argv = sys.argv
+    else:
+        sys.argv.extend(argv)
+
+    try:
+        # Setup argument parser
+        parser = ArgumentParser(description = 'ModBus binary trace decoder.')
+        parser.add_argument('file', help='Records dump (MBTraceRead() output) or MBTrace_t memory image')
+        parser.add_argument('-r', '--raw', dest='raw', type=int, metavar='LEN', help='File is MBTrace_t memory image with LEN (MODBUS_BTRACE_LEN) records')
+        parser.add_argument('-t', '--tick', dest='tick', type=int, default=1000, help='Timestamp unit, us (default 1000)')
+        parser.add_argument('-s', '--slow', dest='slow', type=int, metavar='US', help='Highlight responses with latency of US and longer')
+
+        # Process arguments
+        args = parser.parse_args()
+
+        with open(args.file, 'rb') as f:
+            data = f.read()
+
+        records = read_raw(data, args.raw) if args.raw else read_records(data)
+
+        console = Console()
+        console.print(trace_table(records, args.tick, args.slow))
+        console.print("Records: %d"%(len(records)))
+
+        return 0
+
+    except KeyboardInterrupt:
+        ### handle keyboard interrupt ###
+        return 0
+    except Exception as e:
+        sys.stderr.write(str(e) + "\n")
+        return 2
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,185 @@
+/*
+ * mb_bitmap.c
+ *
+ * Word-wide bitmap helpers (bit per register/coil)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_bitmap.h"
+
+static uint32_t MBBitmapFind(const uint32_t *map, uint32_t from, uint32_t bits, uint32_t inv);
+
+/**
+ * @brief           Checks that all bits of the range are set.
+ *                  Works on whole 32-bit words, so a 125 registers request
+ *                  costs at most 5 mask tests.
+ * @param map       Pointer to bitmap
+ * @param start     First bit of the range
+ * @param num       Number of bits in the range (must be > 0)
+ * @return          Returns 1 if all bits are set
+ */
+uint32_t MBBitmapTest(const uint32_t *map, uint16_t start, uint16_t num)
+{
+	uint32_t last = (uint32_t) start + num - 1;
+	uint32_t w = start >> 5;
+	uint32_t last_w = last >> 5;
+	uint32_t mask = 0xFFFFFFFFUL << (start & 31);
+
+	for (; w < last_w; w++)
+	{
+		if ((map[w] & mask) != mask)
+		{
+			return 0;
+		}
+
+		mask = 0xFFFFFFFFUL;
+	}
+
+	mask &= 0xFFFFFFFFUL >> (31 - (last & 31));
+
+	return (map[w] & mask) == mask;
+}
+
+/**
+ * @brief           Looks for next range of set bits
+ * @param map       Pointer to bitmap
+ * @param from      Bit to start search from
+ * @param bits      Bitmap size in bits (up to 65535, so REG_NUM is limited by RegGen)
+ * @param num       Pointer to range length storage variable
+ * @return          First bit of the range or bits if there are no set bits
+ */
+uint16_t MBBitmapNextRange(const uint32_t *map, uint16_t from, uint16_t bits, uint16_t *num)
+{
+	uint32_t start = MBBitmapFind(map, from, bits, 0);
+	uint32_t end = MBBitmapFind(map, start, bits, 0xFFFFFFFFUL);
+
+	*num = (uint16_t) (end - start);
+
+	return (uint16_t) start;
+}
+
+/**
+ * @brief           Copies bits range to packed bytes array (first bit to LSB of first byte).
+ *                  Unaligned range is shifted by 32 bits at once, unused bits of last byte are cleared.
+ * @param map       Pointer to bitmap
+ * @param start     First bit of the range
+ * @param num       Number of bits in the range
+ * @param dst       Pointer to destination bytes array ((num + 7) / 8 bytes)
+ */
+void MBBitmapExtract(const uint32_t *map, uint16_t start, uint16_t num, uint8_t *dst)
+{
+	uint32_t w = start >> 5;
+	uint32_t sh = start & 31;
+	uint32_t last_w = ((uint32_t) start + num - 1) >> 5;
+	uint32_t word, n;
+
+	while (num > 0)
+	{
+		word = map[w] >> sh;
+
+		if (sh && (w < last_w))
+		{
+			word |= map[w + 1] << (32 - sh);
+		}
+
+		n = (num < 32) ? num : 32;
+
+		if (n < 32)
+		{
+			word &= (1UL << n) - 1;
+		}
+
+		for (; n > 0; n = (n > 8) ? n - 8 : 0)
+		{
+			*dst++ = (uint8_t) word;
+			word >>= 8;
+		}
+
+		num = (num > 32) ? num - 32 : 0;
+		w++;
+	}
+}
+
+/**
+ * @brief           Copies packed bytes array (first bit in LSB of first byte) to bits range.
+ *                  Unaligned range is updated by 32 bits at once.
+ * @param map       Pointer to bitmap
+ * @param start     First bit of the range
+ * @param num       Number of bits in the range
+ * @param src       Pointer to source bytes array ((num + 7) / 8 bytes)
+ */
+void MBBitmapInsert(uint32_t *map, uint16_t start, uint16_t num, const uint8_t *src)
+{
+	uint32_t w = start >> 5;
+	uint32_t sh = start & 31;
+	uint32_t word, mask, n, i;
+
+	while (num > 0)
+	{
+		n = (num < 32) ? num : 32;
+		mask = (n < 32) ? (1UL << n) - 1 : 0xFFFFFFFFUL;
+
+		for (i = 0, word = 0; i < n; i += 8)
+		{
+			word |= (uint32_t) *src++ << i;
+		}
+
+		word &= mask;
+
+		map[w] = (map[w] & ~(mask << sh)) | (word << sh);
+
+		if (sh && (mask >> (32 - sh)))
+		{
+			map[w + 1] = (map[w + 1] & ~(mask >> (32 - sh))) | (word >> (32 - sh));
+		}
+
+		num -= (uint16_t) n;
+		w++;
+	}
+}
+
+/**
+ * @brief           Looks for first set (inv = 0) or cleared (inv = 0xFFFFFFFF) bit
+ * @param map       Pointer to bitmap
+ * @param from      Bit to start search from
+ * @param bits      Bitmap size in bits
+ * @param inv       Inversion mask
+ * @return          Bit position or bits if nothing was found
+ */
+static uint32_t MBBitmapFind(const uint32_t *map, uint32_t from, uint32_t bits, uint32_t inv)
+{
+	uint32_t w = from >> 5;
+	uint32_t word;
+
+	if (from >= bits)
+	{
+		return bits;
+	}
+
+	word = (map[w] ^ inv) & (0xFFFFFFFFUL << (from & 31));
+
+	while (word == 0)
+	{
+		if (++w >= MB_BITMAP_WORDS(bits))
+		{
+			return bits;
+		}
+
+		word = map[w] ^ inv;
+	}
+
+	/*Lowest set bit position*/
+#if defined(__GNUC__)
+	from = (w << 5) + (uint32_t) __builtin_ctz(word);
+#else
+	from = w << 5;
+	while (!(word & 1))
+	{
+		word >>= 1;
+		from++;
+	}
+#endif
+
+	return (from < bits) ? from : bits;
+}
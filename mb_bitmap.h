@@ -0,0 +1,24 @@
+/*
+ * mb_bitmap.h
+ *
+ * Word-wide bitmap helpers (bit per register/coil)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_BITMAP_H_
+#define MB_BITMAP_H_
+
+#include <stdint.h>
+
+#define MB_BITMAP_WORDS(n)			(((n) + 31) / 32)	/*Bitmap size in 32-bit words*/
+#define MB_BITMAP_BIT(map, n)		(((map)[(n) >> 5] >> ((n) & 31)) & 1U)
+#define MB_BITMAP_SETBIT(map, n)	((map)[(n) >> 5] |= 1UL << ((n) & 31))
+#define MB_BITMAP_CLRBIT(map, n)	((map)[(n) >> 5] &= ~(1UL << ((n) & 31)))
+
+uint32_t MBBitmapTest(const uint32_t *map, uint16_t start, uint16_t num);
+uint16_t MBBitmapNextRange(const uint32_t *map, uint16_t from, uint16_t bits, uint16_t *num);
+void MBBitmapExtract(const uint32_t *map, uint16_t start, uint16_t num, uint8_t *dst);
+void MBBitmapInsert(uint32_t *map, uint16_t start, uint16_t num, const uint8_t *src);
+
+#endif /* MB_BITMAP_H_ */
@@ -0,0 +1,18 @@
+/*
+ * mb_crc.h
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_CRC_H_
+#define MB_CRC_H_
+
+#include <stdint.h>
+
+/**
+ * @brief CRC16 of Modbus RTU frame. Bytes are swapped, so result
+ *        is compared with ARR2U16() of frame CRC field
+ */
+uint16_t MBRTU_CRC(uint8_t *buf, uint16_t len);
+
+#endif /* MB_CRC_H_ */
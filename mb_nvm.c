@@ -0,0 +1,325 @@
+/*
+ * mb_nvm.c
+ *
+ * Write-behind journal of non-volatile registers.
+ * Changed registers are appended as records to the active sector. When the sector
+ * is full the last values of all registers are compacted into the other sector,
+ * so each sector is erased once per (sector_size / 8) register changes.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_nvm.h"
+#include "mb_regs.h"
+#include "mb_bitmap.h"
+#include <stddef.h>
+
+#if MODBUS_NVM_ENABLE
+
+#define MB_NVM_MAGIC			0x564E424DUL	/*"MBNV"*/
+#define MB_NVM_BATCH			16				/*Number of registers fetched from store at once*/
+
+extern uint16_t MBRTU_CRC(uint8_t *buf, uint16_t len);
+
+static const MBNvm_Backend_t *nvm = NULL;
+static uint32_t nvm_sector = 0;		/*Active sector*/
+static uint32_t nvm_seq = 0;		/*Active sector sequence number*/
+static uint32_t nvm_wr_pos = 0;		/*Next record offset in active sector*/
+static uint32_t nvm_pend = 0;
+static uint32_t nvm_pend_tick = 0;
+
+/**
+ * @brief Values stored in journal
+ */
+static uint16_t MBNvmVal[REG_NUM];
+
+/**
+ * @brief Registers present in journal (bit per register)
+ */
+static uint32_t MBNvmKnown[MB_BITMAP_WORDS(REG_NUM)];
+
+static MBerror MBNvmFormat(uint32_t sector, uint32_t seq);
+static MBerror MBNvmAppend(uint16_t addr, uint16_t val);
+static void MBNvmPackRec(uint8_t *rec, uint16_t addr, uint16_t val);
+
+/**
+ * @brief           Initializes journal. Must be called before MBRegInit()
+ * @param backend   Storage backend. Sector must hold header and a record per register
+ * @return          Error code
+ */
+MBerror MBNvmInit(const MBNvm_Backend_t *backend)
+{
+	if ((backend == NULL) || (backend->read == NULL) || (backend->write == NULL) || (backend->erase == NULL))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	if (backend->sector_size < MB_NVM_HDR_LEN + (uint32_t) REG_NUM * MB_NVM_REC_LEN)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	nvm = backend;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief   Restores non-volatile registers from journal. Called by MBRegInit().
+ *          Empty or corrupted storage is formatted, registers keep default values.
+ * @return  Error code
+ */
+MBerror MBNvmRestore(void)
+{
+	uint8_t hdr[MB_NVM_HDR_LEN];
+	uint8_t rec[MB_NVM_REC_LEN];
+	uint32_t valid[2], seq[2];
+	uint32_t i, pos;
+	uint16_t addr, val, crc;
+
+	if (nvm == NULL)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		if (nvm->read(i * nvm->sector_size, hdr, MB_NVM_HDR_LEN) != MODBUS_ERR_OK)
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		valid[i] = ((uint32_t) hdr[0] | ((uint32_t) hdr[1] << 8) | ((uint32_t) hdr[2] << 16) | ((uint32_t) hdr[3] << 24)) == MB_NVM_MAGIC;
+		seq[i] = (uint32_t) hdr[4] | ((uint32_t) hdr[5] << 8) | ((uint32_t) hdr[6] << 16) | ((uint32_t) hdr[7] << 24);
+	}
+
+	if (!valid[0] && !valid[1])
+	{
+		return MBNvmFormat(0, 1);
+	}
+
+	/*Previous sector isn't erased after compaction, so both headers are usually valid.
+	  Sector with newer sequence number is active*/
+	if (valid[0] && valid[1])
+	{
+		nvm_sector = ((int32_t) (seq[1] - seq[0]) > 0) ? 1 : 0;
+	}
+	else
+	{
+		nvm_sector = valid[1] ? 1 : 0;
+	}
+
+	nvm_seq = seq[nvm_sector];
+
+	for (pos = MB_NVM_HDR_LEN; pos + MB_NVM_REC_LEN <= nvm->sector_size; pos += MB_NVM_REC_LEN)
+	{
+		if (nvm->read(nvm_sector * nvm->sector_size + pos, rec, MB_NVM_REC_LEN) != MODBUS_ERR_OK)
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		for (i = 0; (i < MB_NVM_REC_LEN) && (rec[i] == 0xFF); i++);
+
+		if (i == MB_NVM_REC_LEN)
+		{
+			/*End of journal*/
+			break;
+		}
+
+		addr = (uint16_t) rec[0] | ((uint16_t) rec[1] << 8);
+		val = (uint16_t) rec[2] | ((uint16_t) rec[3] << 8);
+		crc = (uint16_t) rec[4] | ((uint16_t) rec[5] << 8);
+
+		/*Torn records and registers removed from map are skipped*/
+		if ((crc == MBRTU_CRC(rec, 4)) && (MBRegNvRestore(addr, val) == MODBUS_ERR_OK))
+		{
+			MBNvmVal[addr] = val;
+			MB_BITMAP_SETBIT(MBNvmKnown, addr);
+		}
+	}
+
+	nvm_wr_pos = pos;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief   Writes changed non-volatile registers to journal.
+ *          Registers written with the same value as stored don't use storage.
+ *          Registers not written because of storage error stay pending for next flush.
+ * @return  Error code
+ */
+MBerror MBNvmFlush(void)
+{
+	uint16_t addr[MB_NVM_BATCH];
+	uint16_t val[MB_NVM_BATCH];
+	uint16_t num, i;
+
+	if (nvm == NULL)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	nvm_pend = 0;
+
+	while ((num = MBRegNvFetch(addr, val, MB_NVM_BATCH)) > 0)
+	{
+		for (i = 0; i < num; i++)
+		{
+			if (MB_BITMAP_BIT(MBNvmKnown, addr[i]) && (MBNvmVal[addr[i]] == val[i]))
+			{
+				continue;
+			}
+
+			MBNvmVal[addr[i]] = val[i];
+			MB_BITMAP_SETBIT(MBNvmKnown, addr[i]);
+
+			if (MBNvmAppend(addr[i], val[i]) != MODBUS_ERR_OK)
+			{
+				/*Don't suppress next write of the same value*/
+				MB_BITMAP_CLRBIT(MBNvmKnown, addr[i]);
+
+				/*Failed and not yet written registers are retried by next flush*/
+				for (; i < num; i++)
+				{
+					MBRegNvMarkPending(addr[i]);
+				}
+
+				return MODBUS_ERR_SYS;
+			}
+		}
+	}
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief   Flushes journal MODBUS_NVM_FLUSH_DELAY ms after the first register change.
+ *          Call it periodically from application task. Call MBNvmFlush() to flush on idle.
+ */
+void MBNvmPoll(void)
+{
+	if (!MBRegNvIsPending())
+	{
+		nvm_pend = 0;
+		return;
+	}
+
+	if (!nvm_pend)
+	{
+		nvm_pend = 1;
+		nvm_pend_tick = MODBUS_GET_TICK;
+	}
+	else if ((uint32_t) (MODBUS_GET_TICK - nvm_pend_tick) >= MODBUS_NVM_FLUSH_DELAY)
+	{
+		MBNvmFlush();
+	}
+}
+
+/**
+ * @brief           Erases sector and writes all stored values to it.
+ *                  Header is written last so interrupted compaction leaves previous sector active.
+ * @param sector    Sector number
+ * @param seq       Sector sequence number
+ * @return          Error code
+ */
+static MBerror MBNvmFormat(uint32_t sector, uint32_t seq)
+{
+	uint8_t rec[MB_NVM_REC_LEN];
+	uint32_t base = sector * nvm->sector_size;
+	uint32_t pos = MB_NVM_HDR_LEN;
+	uint16_t addr, num;
+
+	if (nvm->erase(base) != MODBUS_ERR_OK)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	addr = MBBitmapNextRange(MBNvmKnown, 0, REG_NUM, &num);
+
+	while (addr < REG_NUM)
+	{
+		for (; num > 0; num--, addr++, pos += MB_NVM_REC_LEN)
+		{
+			MBNvmPackRec(rec, addr, MBNvmVal[addr]);
+
+			if (nvm->write(base + pos, rec, MB_NVM_REC_LEN) != MODBUS_ERR_OK)
+			{
+				return MODBUS_ERR_SYS;
+			}
+		}
+
+		addr = MBBitmapNextRange(MBNvmKnown, addr, REG_NUM, &num);
+	}
+
+	rec[0] = (uint8_t) MB_NVM_MAGIC;
+	rec[1] = (uint8_t) (MB_NVM_MAGIC >> 8);
+	rec[2] = (uint8_t) (MB_NVM_MAGIC >> 16);
+	rec[3] = (uint8_t) (MB_NVM_MAGIC >> 24);
+	rec[4] = (uint8_t) seq;
+	rec[5] = (uint8_t) (seq >> 8);
+	rec[6] = (uint8_t) (seq >> 16);
+	rec[7] = (uint8_t) (seq >> 24);
+
+	if (nvm->write(base, rec, MB_NVM_HDR_LEN) != MODBUS_ERR_OK)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	nvm_sector = sector;
+	nvm_seq = seq;
+	nvm_wr_pos = pos;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Appends register record to active sector. Compacts journal if sector is full.
+ * @param addr  Register address
+ * @param val   Register value
+ * @return      Error code
+ */
+static MBerror MBNvmAppend(uint16_t addr, uint16_t val)
+{
+	uint8_t rec[MB_NVM_REC_LEN];
+
+	if (nvm_wr_pos + MB_NVM_REC_LEN > nvm->sector_size)
+	{
+		/*Value is already in MBNvmVal*/
+		return MBNvmFormat(nvm_sector ^ 1, nvm_seq + 1);
+	}
+
+	MBNvmPackRec(rec, addr, val);
+
+	if (nvm->write(nvm_sector * nvm->sector_size + nvm_wr_pos, rec, MB_NVM_REC_LEN) != MODBUS_ERR_OK)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	nvm_wr_pos += MB_NVM_REC_LEN;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Packs register record
+ * @param rec   Pointer to record buffer
+ * @param addr  Register address
+ * @param val   Register value
+ */
+static void MBNvmPackRec(uint8_t *rec, uint16_t addr, uint16_t val)
+{
+	uint16_t crc;
+
+	rec[0] = (uint8_t) addr;
+	rec[1] = (uint8_t) (addr >> 8);
+	rec[2] = (uint8_t) val;
+	rec[3] = (uint8_t) (val >> 8);
+	crc = MBRTU_CRC(rec, 4);
+	rec[4] = (uint8_t) crc;
+	rec[5] = (uint8_t) (crc >> 8);
+	rec[6] = 0;
+	rec[7] = 0;
+}
+
+#endif /*MODBUS_NVM_ENABLE*/
@@ -0,0 +1,34 @@
+/*
+ * mb_nvm.h
+ *
+ * Write-behind journal of non-volatile registers
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_NVM_H_
+#define MB_NVM_H_
+
+#include "mb_pdu.h"
+#include <stdint.h>
+
+#define MB_NVM_HDR_LEN			8	/*Sector header: magic (4 bytes) + sequence number (4 bytes)*/
+#define MB_NVM_REC_LEN			8	/*Record: addr (2 bytes) + value (2 bytes) + CRC (2 bytes) + pad (2 bytes)*/
+
+/**
+ * @brief Storage backend. Two sectors of sector_size bytes starting at offset 0.
+ *        Erased memory reads as 0xFF, write only clears bits (flash semantics).
+ */
+typedef struct {
+	MBerror (*read)(uint32_t offset, uint8_t *data, uint32_t len);			/*!< Read function pointer */
+	MBerror (*write)(uint32_t offset, const uint8_t *data, uint32_t len);	/*!< Write function pointer */
+	MBerror (*erase)(uint32_t offset);										/*!< Sector erase function pointer */
+	uint32_t sector_size;													/*!< Sector size in bytes */
+} MBNvm_Backend_t;
+
+MBerror MBNvmInit(const MBNvm_Backend_t *backend);
+MBerror MBNvmRestore(void);
+MBerror MBNvmFlush(void);
+void MBNvmPoll(void);
+
+#endif /* MB_NVM_H_ */
@@ -0,0 +1,142 @@
+/*
+ * mb_nvm_file.c
+ *
+ * File storage backend of non-volatile registers journal (Linux testing).
+ * Emulates flash: erased bytes are 0xFF and write only clears bits.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_nvm_file.h"
+#include <stdio.h>
+#include <string.h>
+
+#if MODBUS_NVM_ENABLE
+
+static FILE *nvm_file = NULL;
+
+static MBerror MBNvmFileRead(uint32_t offset, uint8_t *data, uint32_t len);
+static MBerror MBNvmFileWrite(uint32_t offset, const uint8_t *data, uint32_t len);
+static MBerror MBNvmFileErase(uint32_t offset);
+
+static MBNvm_Backend_t nvm_file_backend = {
+	.read = MBNvmFileRead,
+	.write = MBNvmFileWrite,
+	.erase = MBNvmFileErase,
+	.sector_size = 0
+};
+
+/**
+ * @brief               Opens (creates) storage file and initializes journal with it
+ * @param path          Storage file path
+ * @param sector_size   Sector size in bytes
+ * @return              Error code
+ */
+MBerror MBNvmFileInit(const char *path, uint32_t sector_size)
+{
+	long size;
+
+	if (nvm_file != NULL)
+	{
+		fclose(nvm_file);
+	}
+
+	nvm_file = fopen(path, "r+b");
+
+	if (nvm_file == NULL)
+	{
+		nvm_file = fopen(path, "w+b");
+	}
+
+	if (nvm_file == NULL)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	nvm_file_backend.sector_size = sector_size;
+
+	fseek(nvm_file, 0, SEEK_END);
+	size = ftell(nvm_file);
+
+	/*New file is erased*/
+	if ((size < 0) || ((uint32_t) size < 2 * sector_size))
+	{
+		if ((MBNvmFileErase(0) != MODBUS_ERR_OK) || (MBNvmFileErase(sector_size) != MODBUS_ERR_OK))
+		{
+			return MODBUS_ERR_SYS;
+		}
+	}
+
+	return MBNvmInit(&nvm_file_backend);
+}
+
+static MBerror MBNvmFileRead(uint32_t offset, uint8_t *data, uint32_t len)
+{
+	if ((fseek(nvm_file, (long) offset, SEEK_SET) != 0) || (fread(data, 1, len, nvm_file) != len))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	return MODBUS_ERR_OK;
+}
+
+static MBerror MBNvmFileWrite(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+	uint8_t buf[64];
+	uint32_t i, n;
+
+	while (len > 0)
+	{
+		n = (len > sizeof(buf)) ? sizeof(buf) : len;
+
+		if (MBNvmFileRead(offset, buf, n) != MODBUS_ERR_OK)
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		for (i = 0; i < n; i++)
+		{
+			buf[i] &= data[i];
+		}
+
+		if ((fseek(nvm_file, (long) offset, SEEK_SET) != 0) || (fwrite(buf, 1, n, nvm_file) != n))
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		offset += n;
+		data += n;
+		len -= n;
+	}
+
+	return (fflush(nvm_file) == 0) ? MODBUS_ERR_OK : MODBUS_ERR_SYS;
+}
+
+static MBerror MBNvmFileErase(uint32_t offset)
+{
+	uint8_t buf[64];
+	uint32_t n, len = nvm_file_backend.sector_size;
+
+	memset(buf, 0xFF, sizeof(buf));
+
+	if (fseek(nvm_file, (long) offset, SEEK_SET) != 0)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	while (len > 0)
+	{
+		n = (len > sizeof(buf)) ? sizeof(buf) : len;
+
+		if (fwrite(buf, 1, n, nvm_file) != n)
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		len -= n;
+	}
+
+	return (fflush(nvm_file) == 0) ? MODBUS_ERR_OK : MODBUS_ERR_SYS;
+}
+
+#endif /*MODBUS_NVM_ENABLE*/
@@ -0,0 +1,16 @@
+/*
+ * mb_nvm_file.h
+ *
+ * File storage backend of non-volatile registers journal (Linux testing)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_NVM_FILE_H_
+#define MB_NVM_FILE_H_
+
+#include "mb_nvm.h"
+
+MBerror MBNvmFileInit(const char *path, uint32_t sector_size);
+
+#endif /* MB_NVM_FILE_H_ */
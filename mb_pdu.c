@@ -9,47 +9,123 @@
 #include "mb_regs.h"
 #include <string.h>
 
-/**
- * @brief Supported function codes definitions
- */
-#define MODBUS_FUNC_RDCOIL 		1 	/*Read Coil*/
-#define MODBUS_FUNC_RDDINP 		2 	/*Read discrete input*/
-#define MODBUS_FUNC_RDHLDREGS 	3	/*Read holding register*/
-#define MODBUS_FUNC_RDINREGS  	4 	/*Read input register*/
-#define MODBUS_FUNC_WRSCOIL  	5 	/*Write single coil*/
-#define MODBUS_FUNC_WRSREG  	6 	/*Write single register*/
-#define MODBUS_FUNC_WRMCOILS 	15  /*Write multiple coils*/
-#define MODBUS_FUNC_WRMREGS 	16  /*Write multiple registers*/
-
 #if MODBUS_REGS_ENABLE
 extern MBerror MBRegInit(void *arg);
 extern MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **regs);
 extern MBerror MBRegWriteCallback(uint16_t addr, uint16_t val);
 #endif /*MODBUS_REGS_ENABLE*/
 #if MODBUS_COILS_ENABLE
-extern MBerror MBCoilsReadCallback(uint16_t addr, uint16_t num, uint8_t **coils);
+extern MBerror MBCoilsReadCallback(uint16_t addr, uint16_t num, uint8_t *coils);
 extern MBerror MBCoilWriteCallback(uint16_t addr, uint8_t val); //TODO Combine with next function
 extern MBerror MBCoilsWriteCallback(uint16_t addr, uint16_t num, uint8_t *coils);
 #endif /*MODBUS_COILS_ENABLE*/
 #if MODBUS_DINP_ENABLE
-extern MBerror MBInputsReadCallback(uint16_t addr, uint16_t num, uint8_t **coils);
+extern MBerror MBInputsReadCallback(uint16_t addr, uint16_t num, uint8_t *coils);
 #endif /*MODBUS_DINP_ENABLE*/
 
+#if MODBUS_COILS_ENABLE || MODBUS_DINP_ENABLE
+static MBerror MB_PDU_ReadBits(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_REGS_ENABLE
+static MBerror MB_PDU_ReadRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_COILS_ENABLE
+static MBerror MB_PDU_WriteCoil(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_WRREG_ENABLE
+static MBerror MB_PDU_WriteReg(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_COILS_ENABLE && MODBUS_WRMCOILS_ENABLE
+static MBerror MB_PDU_WriteCoils(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_WRMREGS_ENABLE
+static MBerror MB_PDU_WriteRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_FILE_ENABLE
+static MBerror MB_PDU_ReadFile(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+static MBerror MB_PDU_WriteFile(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_MSKWRREG_ENABLE
+static MBerror MB_PDU_MaskWriteReg(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+#if MODBUS_RDWRMREGS_ENABLE
+static MBerror MB_PDU_ReadWriteRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#endif
+
+#if MODBUS_PDU_CUSTOM_ENABLE
+#define MB_PDU_TABLE_CONST
+#else
+#define MB_PDU_TABLE_CONST          const
+#endif
+
+/**
+ * @brief Function descriptor. Request length is len + value of byte count field at cnt offset
+ *        (0 for fixed length requests). len 0 means request length is checked by handler.
+ */
+typedef struct {
+    MB_PDU_Handler_t handler;                   /* Function handler */
+    uint8_t len;                                /* Request length without data bytes */
+    uint8_t cnt;                                /* Byte count field offset */
+    uint8_t resp;                               /* Fixed response length, 0 - checked by handler */
+} MB_PDU_Func_t;
+
+/**
+ * @brief Functions indexed by function code. Built-in functions are set at compile time,
+ *        entries without handler are answered with exception 01 (ILLEGAL FUNCTION).
+ */
+static MB_PDU_Func_t MB_PDU_TABLE_CONST MB_PDU_Funcs[MB_PDU_FUNC_NUM] = {
+#if MODBUS_COILS_ENABLE
+    [MODBUS_FUNC_RDCOIL]    = {MB_PDU_ReadBits, 5, 0, 0},
+    [MODBUS_FUNC_WRSCOIL]   = {MB_PDU_WriteCoil, 5, 0, 5},
+#endif
+#if MODBUS_DINP_ENABLE
+    [MODBUS_FUNC_RDDINP]    = {MB_PDU_ReadBits, 5, 0, 0},
+#endif
+#if MODBUS_REGS_ENABLE
+    [MODBUS_FUNC_RDHLDREGS] = {MB_PDU_ReadRegs, 5, 0, 0},
+    [MODBUS_FUNC_RDINREGS]  = {MB_PDU_ReadRegs, 5, 0, 0},
+#endif
+#if MODBUS_WRREG_ENABLE
+    [MODBUS_FUNC_WRSREG]    = {MB_PDU_WriteReg, 5, 0, 5},
+#endif
+#if MODBUS_COILS_ENABLE && MODBUS_WRMCOILS_ENABLE
+    [MODBUS_FUNC_WRMCOILS]  = {MB_PDU_WriteCoils, 6, 5, 5},
+#endif
+#if MODBUS_WRMREGS_ENABLE
+    [MODBUS_FUNC_WRMREGS]   = {MB_PDU_WriteRegs, 6, 5, 5},
+#endif
+#if MODBUS_FILE_ENABLE
+    [MODBUS_FUNC_RDFILE]    = {MB_PDU_ReadFile, 2, 1, 0},
+    [MODBUS_FUNC_WRFILE]    = {MB_PDU_WriteFile, 2, 1, 0},
+#endif
+#if MODBUS_MSKWRREG_ENABLE
+    [MODBUS_FUNC_MSKWRREG]  = {MB_PDU_MaskWriteReg, 7, 0, 7},
+#endif
+#if MODBUS_RDWRMREGS_ENABLE
+    [MODBUS_FUNC_RDWRMREGS] = {MB_PDU_ReadWriteRegs, 10, 9, 0},
+#endif
+};
+
 /**
  * @brief               Parser for Modbus PDU data (consists of Function code
  *                      and function data). Also writes response data.
  * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
  * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
  * @param pRespLen      Pointer to response length
- * @return              Exception code
+ * @return              Exception code. Internal errors of handlers are
+ *                      reported as MODBUS_ERR_DEVFAIL
  */
-MBerror MB_PDU_Parser(uint8_t *pReqData, uint8_t *pRespData, uint16_t *pRespLen)
+MBerror MB_PDU_Parser(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
 {
     MB_ASSERT(pReqData != NULL);
     MB_ASSERT(pRespData != NULL);
     MB_ASSERT(pRespLen != NULL);
+    MB_ASSERT(respCap >= 2);
 
-    MBerror err = MODBUS_ERR_OK;
+    MBerror err = MODBUS_ERR_ILLEGFUNC;
+    const MB_PDU_Func_t *func;
     *pRespLen = 0;
 
     /*--PDU---
@@ -57,226 +133,543 @@ MBerror MB_PDU_Parser(uint8_t *pReqData, uint8_t *pRespData, uint16_t *pRespLen)
      * N bytes - Data
      */
 
+    if (reqLen < 1)
+    {
+        return MODBUS_ERR_SYS;
+    }
+
     uint8_t fcode = pReqData[0];                /* Function code */
-    uint8_t *pdata = &pReqData[1];              /* PDU data */
-    uint16_t start_addr = ARR2U16(pdata);       /* start address */
-    uint16_t points_num = ARR2U16(pdata + 2);   /* number of coils/regs */
 
-    /*check function*/
-    switch (fcode)
+    /*Codes 128 - 255 are reserved for exception responses*/
+    if ((fcode < MB_PDU_FUNC_NUM) && (MB_PDU_Funcs[fcode].handler != NULL))
     {
-#if MODBUS_COILS_ENABLE
-        /* Function 01: read coil status */
-        case MODBUS_FUNC_RDCOIL:
-#endif /*MODBUS_COILS_ENABLE*/
+        func = &MB_PDU_Funcs[fcode];
 
-#if MODBUS_DINP_ENABLE
-        /* Function 02: read input status */
-        case MODBUS_FUNC_RDDINP:
-#endif /*MODBUS_DINP_ENABLE*/
+        /*Whole request is checked once here, so handlers access its fields without checks*/
+        if ((func->len != 0) &&
+            ((reqLen < func->len) || (reqLen != func->len + (func->cnt ? pReqData[func->cnt] : 0))))
+        {
+            /*Truncated or oversized request. Send exception 03*/
+            err = MODBUS_ERR_ILLEGVAL;
+        }
+        else if (respCap < func->resp)
+        {
+            /*Response buffer is too small for fixed length response*/
+            err = MODBUS_ERR_SYS;
+        }
+        else
+        {
+            err = func->handler(pReqData, reqLen, pRespData, respCap, pRespLen);
+        }
+    }
 
-#if MODBUS_COILS_ENABLE || MODBUS_DINP_ENABLE
+    /* Exception response */
+    if (err != MODBUS_ERR_OK)
+    {
+        /*Internal error codes must not reach the client*/
+        if (err > MODBUS_ERR_DEVFAIL)
         {
-            uint8_t *resp_values = NULL;
+            err = MODBUS_ERR_DEVFAIL;
+        }
+
+        pRespData[0] = fcode | 0x80;
+        pRespData[1] = err;
+        *pRespLen = 2;
+    }
+
+    return err;
+}
 
-            if (points_num >= 1 && points_num <= 2000)
-            {
+#if MODBUS_PDU_CUSTOM_ENABLE
+/**
+ * @brief               Sets handler of function code. Call it on initialization before
+ *                      Modbus is started. Built-in function handlers may be replaced too.
+ * @param fcode         Function code (1 - 127)
+ * @param handler       Function handler, NULL to disable function
+ * @return              Error code
+ */
+MBerror MB_PDU_RegisterHandler(uint8_t fcode, MB_PDU_Handler_t handler)
+{
+    if ((fcode == 0) || (fcode >= MB_PDU_FUNC_NUM))
+    {
+        return MODBUS_ERR_SYS;
+    }
+
+    /*Custom handlers check request length and response capacity themselves*/
+    MB_PDU_Funcs[fcode].handler = handler;
+    MB_PDU_Funcs[fcode].len = 0;
+    MB_PDU_Funcs[fcode].cnt = 0;
+    MB_PDU_Funcs[fcode].resp = 0;
+
+    return MODBUS_ERR_OK;
+}
+#endif /*MODBUS_PDU_CUSTOM_ENABLE*/
+
+#if MODBUS_COILS_ENABLE || MODBUS_DINP_ENABLE
+/**
+ * @brief               Functions 01 & 02: read coils/discrete inputs status
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_ReadBits(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err = MODBUS_ERR_ILLEGFUNC;
+    uint8_t fcode = pReqData[0];
+    uint16_t start_addr = ARR2U16(&pReqData[1]);
+    uint16_t points_num = ARR2U16(&pReqData[3]);
+    uint8_t resp_bytes = (uint8_t) ((points_num + 7) / 8); /*response bytes number*/
+
+    if ((points_num < 1) || (points_num > 2000))
+    {
+        /*Send exception 03*/
+        err = MODBUS_ERR_ILLEGVAL;
+    }
+    else if (2 + resp_bytes > respCap)
+    {
+        err = MODBUS_ERR_SYS;
+    }
+    else
+    {
+        /*Values are packed directly to response*/
 #if MODBUS_COILS_ENABLE
-                if (fcode == MODBUS_FUNC_RDCOIL)
-                {
-                    /*coils read callback*/
-                    err = MBCoilsReadCallback(start_addr, points_num, &resp_values);
-                }
+        if (fcode == MODBUS_FUNC_RDCOIL)
+        {
+            /*coils read callback*/
+            err = MBCoilsReadCallback(start_addr, points_num, &pRespData[2]);
+        }
 #endif /*MODBUS_COILS_ENABLE*/
 
 #if MODBUS_DINP_ENABLE
-				if (fcode == MODBUS_FUNC_RDDINP)
-				{
-					/*dinputs read callback*/
-					err = MBInputsReadCallback(start_addr, points_num, &resp_values);
-				}
-#endif /*MODBUS_DINP_ENABLE*/
-            }
-            else
-            {
-                /*Send exception 03*/
-                err = MODBUS_ERR_ILLEGVAL;
-            }
-
-            if ((err == MODBUS_ERR_OK) && (resp_values != NULL))
-            {
-                /*Prepare response PDU message*/
-                uint8_t resp_bytes = (uint8_t) ((points_num + 7) / 8); /*response bytes number*/
-
-                pRespData[0] = fcode;
-                pRespData[1] = resp_bytes;
-
-                uint16_t i;
-                for (i = 0; i < resp_bytes; i++)
-                {
-                    pRespData[2 + i] = resp_values[i];
-                }
-
-                *pRespLen = resp_bytes + 2;
-            }
+        if (fcode == MODBUS_FUNC_RDDINP)
+        {
+            /*dinputs read callback*/
+            err = MBInputsReadCallback(start_addr, points_num, &pRespData[2]);
         }
-            break;
+#endif /*MODBUS_DINP_ENABLE*/
+    }
+
+    if (err == MODBUS_ERR_OK)
+    {
+        /*Prepare response PDU message*/
+        pRespData[0] = fcode;
+        pRespData[1] = resp_bytes;
+
+        *pRespLen = resp_bytes + 2;
+    }
+
+    return err;
+}
 #endif /*MODBUS_COILS_ENABLE || MODBUS_DINP_ENABLE*/
 
 #if MODBUS_REGS_ENABLE
-	/* Function 03: read holding registers */
-	case MODBUS_FUNC_RDHLDREGS:
-	/* Function 04: read input registers */
-	case MODBUS_FUNC_RDINREGS:
-		{
-			uint16_t *reg_values = NULL;
-
-			if (points_num >= 1 && points_num <= 125)
-			{
-				/*reg read callback*/
-				err = MBRegReadCallback(start_addr, points_num, &reg_values);
-			}
-			else
-			{
-				/*Send exception 03*/
-				err = MODBUS_ERR_ILLEGVAL;
-			}
-
-			if ((err == MODBUS_ERR_OK) && (reg_values != NULL))
-			{
-				/*Prepare response PDU message*/
-				uint16_t resp_bytes = points_num * 2; /*response bytes number*/
-
-				pRespData[0] = fcode;
-				pRespData[1] = resp_bytes;
-
-				uint16_t i;
-				for (i = 0; i < points_num; i++)
-				{
-					U162ARR(reg_values[i], &pRespData[2 + 2*i]);
-				}
-
-				*pRespLen = resp_bytes + 2;
-			}
-		}
-		break;
+/**
+ * @brief               Functions 03 & 04: read holding/input registers
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_ReadRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err = MODBUS_ERR_OK;
+    uint16_t start_addr = ARR2U16(&pReqData[1]);
+    uint16_t points_num = ARR2U16(&pReqData[3]);
+    uint16_t *reg_values = NULL;
+
+    if ((points_num < 1) || (points_num > 125))
+    {
+        /*Send exception 03*/
+        err = MODBUS_ERR_ILLEGVAL;
+    }
+    else if (2 + 2*points_num > respCap)
+    {
+        err = MODBUS_ERR_SYS;
+    }
+    else
+    {
+        /*reg read callback*/
+        err = MBRegReadCallback(start_addr, points_num, &reg_values);
+    }
+
+    if ((err == MODBUS_ERR_OK) && (reg_values != NULL))
+    {
+        /*Prepare response PDU message*/
+        uint16_t resp_bytes = points_num * 2; /*response bytes number*/
+
+        pRespData[0] = pReqData[0];
+        pRespData[1] = resp_bytes;
+
+        uint16_t i;
+        for (i = 0; i < points_num; i++)
+        {
+            U162ARR(reg_values[i], &pRespData[2 + 2*i]);
+        }
+
+        *pRespLen = resp_bytes + 2;
+    }
+
+    return err;
+}
 #endif /*MODBUS_REGS_ENABLE*/
 
 #if MODBUS_COILS_ENABLE
-        /* Function 05: force single coil */
-        case MODBUS_FUNC_WRSCOIL:
+/**
+ * @brief               Function 05: force single coil
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_WriteCoil(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint16_t val = ARR2U16(&pReqData[3]);
+    uint8_t c_val = 0;
+
+    if (val)
+    {
+        if (val == 0xFF00)
         {
-            uint16_t val = points_num;
-            uint8_t c_val = 0;
-
-            if (val)
-            {
-                if (val == 0xFF00)
-                {
-                    /* coil is ON */
-                    c_val = 1;
-                }
-                else
-                {
-                    /*Send exception 03*/
-                    err = MODBUS_ERR_ILLEGVAL;
-                    break;
-                }
-            }
-
-            /*coil write callback*/
-            err = MBCoilsWriteCallback(start_addr, 1, &c_val);
-
-            if (err == MODBUS_ERR_OK)
-            {
-                memcpy(pRespData, pReqData, 5);
-                *pRespLen = 5;
-            }
+            /* coil is ON */
+            c_val = 1;
         }
-        break;
+        else
+        {
+            /*Send exception 03*/
+            return MODBUS_ERR_ILLEGVAL;
+        }
+    }
+
+    /*coil write callback*/
+    err = MBCoilsWriteCallback(ARR2U16(&pReqData[1]), 1, &c_val);
+
+    if (err == MODBUS_ERR_OK)
+    {
+        memcpy(pRespData, pReqData, 5);
+        *pRespLen = 5;
+    }
+
+    return err;
+}
 #endif /*MODBUS_COILS_ENABLE*/
 
 #if MODBUS_WRREG_ENABLE
-        /* Function 06: Preset Single Register */
-        case MODBUS_FUNC_WRSREG:
-        {
-            /*reg write callback*/
-            err = MBRegsWriteCallback(start_addr, 1, &pdata[2]);
-
-            if (err == MODBUS_ERR_OK)
-            {
-                memcpy(pRespData, pReqData, 5);
-                *pRespLen = 5;
-            }
-        }
-        break;
-#endif /*MODBUS_REGS_ENABLE*/
+/**
+ * @brief               Function 06: preset single register
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_WriteReg(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    /*reg write callback*/
+    MBerror err = MBRegsWriteCallback(ARR2U16(&pReqData[1]), 1, &pReqData[3]);
+
+    if (err == MODBUS_ERR_OK)
+    {
+        memcpy(pRespData, pReqData, 5);
+        *pRespLen = 5;
+    }
+
+    return err;
+}
+#endif /*MODBUS_WRREG_ENABLE*/
 
 #if MODBUS_COILS_ENABLE && MODBUS_WRMCOILS_ENABLE
-        /* Function 15: Write Multiple Coils */
-        case MODBUS_FUNC_WRMCOILS:
+/**
+ * @brief               Function 15: write multiple coils
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_WriteCoils(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint16_t points_num = ARR2U16(&pReqData[3]);
+    uint8_t byte_cnt = pReqData[5];
+
+    if ((points_num >= 1 && points_num <= 1968) && ((points_num + 7) / 8 == byte_cnt))
+    {
+        err = MBCoilsWriteCallback(ARR2U16(&pReqData[1]), points_num, &pReqData[6]);
+
+        if (err == MODBUS_ERR_OK)
         {
-            uint8_t byte_cnt = pdata[4];
-
-            if ((points_num >= 1 && points_num <= 1968) && ((points_num + 7) / 8 == byte_cnt))
-            {
-                err = MBCoilsWriteCallback(start_addr, points_num, &pdata[5]);
-
-                if (err == MODBUS_ERR_OK)
-                {
-                    memcpy(pRespData, pReqData, 5);
-                    *pRespLen = 5;
-                }
-            }
-            else
-            {
-                /*Send exception 03*/
-                err = MODBUS_ERR_ILLEGVAL;
-            }
+            memcpy(pRespData, pReqData, 5);
+            *pRespLen = 5;
         }
-        break;
+    }
+    else
+    {
+        /*Send exception 03*/
+        err = MODBUS_ERR_ILLEGVAL;
+    }
+
+    return err;
+}
 #endif /*MODBUS_COILS_ENABLE && MODBUS_WRMCOILS_ENABLE*/
 
 #if MODBUS_WRMREGS_ENABLE
-        /* Function 16: Write multiple registers */
-        case MODBUS_FUNC_WRMREGS:
+/**
+ * @brief               Function 16: write multiple registers
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_WriteRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint16_t points_num = ARR2U16(&pReqData[3]);
+    uint8_t byte_cnt = pReqData[5];
+
+    if ((points_num >= 1 && points_num <= 123) &&
+        (byte_cnt == 2*points_num))
+    {
+        err = MBRegsWriteCallback(ARR2U16(&pReqData[1]), points_num, &pReqData[6]);
+    }
+    else
+    {
+        /*Send exception 03*/
+        err = MODBUS_ERR_ILLEGVAL;
+    }
+
+    if (err == MODBUS_ERR_OK)
+    {
+        /*Copy function, start address, quantity of registers*/
+        memcpy(pRespData, pReqData, 5);
+        *pRespLen = 5;
+    }
+
+    return err;
+}
+#endif /*MODBUS_WRMREGS_ENABLE*/
+
+#if MODBUS_FILE_ENABLE
+/**
+ * @brief               Function 20: read file record. Request consists of sub-requests
+ *                      (reference type, file number, record number, record length),
+ *                      response contains record data of every sub-request.
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_ReadFile(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint8_t byte_cnt = pReqData[1];
+    uint8_t *sub;
+    uint16_t resp_len = 2;
+    uint16_t num;
+
+    if ((byte_cnt < 7) || (byte_cnt > 245) || (byte_cnt % 7))
+    {
+        /*Send exception 03*/
+        return MODBUS_ERR_ILLEGVAL;
+    }
+
+    /*Check all sub-requests and response length first*/
+    for (sub = &pReqData[2]; sub < &pReqData[2 + byte_cnt]; sub += 7)
+    {
+        num = ARR2U16(&sub[5]);
+
+        if ((sub[0] != MB_FILE_REF_TYPE) || (num == 0) || (resp_len + 2 + 2*num > MB_PDU_MAX_LEN))
         {
-            uint8_t byte_cnt = pdata[4];
-
-            if ((points_num >= 1 && points_num <= 123) &&
-                (byte_cnt == 2*points_num))
-            {
-                err = MBRegsWriteCallback(start_addr, points_num, &pdata[5]);
-            }
-            else
-            {
-                /*Send exception 03*/
-                err = MODBUS_ERR_ILLEGVAL;
-            }
-
-            if (err == MODBUS_ERR_OK)
-            {
-                /*Copy function, start address, quantity of registers*/
-                memcpy(pRespData, pReqData, 5);
-                *pRespLen = 5;
-            }
+            return MODBUS_ERR_ILLEGVAL;
         }
-        break;
-#endif /*MODBUS_WRMREGS_ENABLE*/
 
-        default:
-            /* Send exception 01 (ILLEGAL FUNCTION) */
-            err = MODBUS_ERR_ILLEGFUNC;
-            break;
+        if ((ARR2U16(&sub[3])) > MB_FILE_MAX_RECORD)
+        {
+            return MODBUS_ERR_ILLEGADDR;
+        }
+
+        resp_len += 2 + 2*num;
     }
 
-    /* Exception response */
-    if (err != MODBUS_ERR_OK)
+    if (resp_len > respCap)
     {
-        pRespData[0] |= fcode | 0x80;
-        pRespData[1] = err;
-        *pRespLen = 2;
+        return MODBUS_ERR_SYS;
+    }
+
+    resp_len = 2;
+
+    for (sub = &pReqData[2]; sub < &pReqData[2 + byte_cnt]; sub += 7)
+    {
+        num = ARR2U16(&sub[5]);
+
+        /*File response length, reference type, record data*/
+        pRespData[resp_len] = (uint8_t) (1 + 2*num);
+        pRespData[resp_len + 1] = MB_FILE_REF_TYPE;
+
+        err = MBFileReadCallback(ARR2U16(&sub[1]), ARR2U16(&sub[3]), num, &pRespData[resp_len + 2]);
+
+        if (err != MODBUS_ERR_OK)
+        {
+            return err;
+        }
+
+        resp_len += 2 + 2*num;
+    }
+
+    pRespData[0] = pReqData[0];
+    pRespData[1] = (uint8_t) (resp_len - 2);
+    *pRespLen = resp_len;
+
+    return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief               Function 21: write file record. Request consists of sub-requests
+ *                      (reference type, file number, record number, record length, record data),
+ *                      response is echo of request. Sub-requests are written in order after
+ *                      all of them are checked.
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_WriteFile(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint8_t byte_cnt = pReqData[1];
+    uint8_t *end = &pReqData[2 + byte_cnt];
+    uint8_t *sub;
+    uint16_t num;
+
+    if ((byte_cnt < 9) || (byte_cnt > 251))
+    {
+        /*Send exception 03*/
+        return MODBUS_ERR_ILLEGVAL;
+    }
+
+    /*Sub-requests must fill byte count exactly*/
+    for (sub = &pReqData[2]; sub < end; sub += 7 + 2*num)
+    {
+        num = (sub + 7 <= end) ? ARR2U16(&sub[5]) : 0;
+
+        if ((sub[0] != MB_FILE_REF_TYPE) || (num == 0) || (sub + 7 + 2*num > end))
+        {
+            return MODBUS_ERR_ILLEGVAL;
+        }
+
+        if ((ARR2U16(&sub[3])) > MB_FILE_MAX_RECORD)
+        {
+            return MODBUS_ERR_ILLEGADDR;
+        }
+    }
+
+    /*Response is echo of request*/
+    if (2 + byte_cnt > respCap)
+    {
+        return MODBUS_ERR_SYS;
+    }
+
+    for (sub = &pReqData[2]; sub < end; sub += 7 + 2*num)
+    {
+        num = ARR2U16(&sub[5]);
+
+        err = MBFileWriteCallback(ARR2U16(&sub[1]), ARR2U16(&sub[3]), num, &sub[7]);
+
+        if (err != MODBUS_ERR_OK)
+        {
+            return err;
+        }
+    }
+
+    memcpy(pRespData, pReqData, 2 + byte_cnt);
+    *pRespLen = 2 + byte_cnt;
+
+    return MODBUS_ERR_OK;
+}
+#endif /*MODBUS_FILE_ENABLE*/
+
+#if MODBUS_MSKWRREG_ENABLE
+/**
+ * @brief               Function 22: mask write register
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_MaskWriteReg(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err = MBRegMaskWriteCallback(ARR2U16(&pReqData[1]), ARR2U16(&pReqData[3]), ARR2U16(&pReqData[5]));
+
+    if (err == MODBUS_ERR_OK)
+    {
+        /*Response is echo of request*/
+        memcpy(pRespData, pReqData, 7);
+        *pRespLen = 7;
+    }
+
+    return err;
+}
+#endif /*MODBUS_MSKWRREG_ENABLE*/
+
+#if MODBUS_RDWRMREGS_ENABLE
+/**
+ * @brief               Function 23: read/write multiple registers
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+static MBerror MB_PDU_ReadWriteRegs(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen)
+{
+    MBerror err;
+    uint16_t points_num = ARR2U16(&pReqData[3]);
+    uint16_t wr_num = ARR2U16(&pReqData[7]);
+    uint8_t byte_cnt = pReqData[9];
+
+    if ((points_num < 1) || (points_num > 125) ||
+        (wr_num < 1) || (wr_num > 121) || (byte_cnt != 2*wr_num))
+    {
+        /*Send exception 03*/
+        err = MODBUS_ERR_ILLEGVAL;
+    }
+    else if (2 + 2*points_num > respCap)
+    {
+        err = MODBUS_ERR_SYS;
+    }
+    else
+    {
+        /*Write and read to response under one registers lock*/
+        err = MBRegsReadWriteCallback(ARR2U16(&pReqData[1]), points_num, &pRespData[2],
+                                      ARR2U16(&pReqData[5]), wr_num, &pReqData[10]);
+    }
+
+    if (err == MODBUS_ERR_OK)
+    {
+        pRespData[0] = pReqData[0];
+        pRespData[1] = (uint8_t) (points_num * 2);
+
+        *pRespLen = points_num * 2 + 2;
     }
 
     return err;
 }
+#endif /*MODBUS_RDWRMREGS_ENABLE*/
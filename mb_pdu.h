@@ -17,15 +17,61 @@
 #define MODBUS_ERR_ILLEGFUNC		1
 #define MODBUS_ERR_ILLEGADDR		2
 #define MODBUS_ERR_ILLEGVAL			3
+#define MODBUS_ERR_DEVFAIL			4	/*Server device failure, sent for internal errors*/
 /**
  * @brief Additional internal error codes
  * */
 #define MODBUS_ERR_SYS				10
 #define MODBUS_ERR_INTFS			11
+#define MODBUS_ERR_TIMEOUT			12	/*Master: response timeout*/
+#define MODBUS_ERR_CRC				13	/*Master: response CRC error*/
+#define MODBUS_ERR_VALUE			14	/*Master: incorrect request or response*/
+#define MODBUS_ERR_MASTER			15	/*Master: incorrect master configuration*/
+#define MODBUS_ERR_BUSY				16	/*Master: no free requests*/
+#define MODBUS_ERR_OFFLINE			17	/*Master: slave is quarantined*/
+
+/**
+ * @brief Supported function codes definitions
+ */
+#define MODBUS_FUNC_RDCOIL 		1 	/*Read Coil*/
+#define MODBUS_FUNC_RDDINP 		2 	/*Read discrete input*/
+#define MODBUS_FUNC_RDHLDREGS 	3	/*Read holding register*/
+#define MODBUS_FUNC_RDINREGS  	4 	/*Read input register*/
+#define MODBUS_FUNC_WRSCOIL  	5 	/*Write single coil*/
+#define MODBUS_FUNC_WRSREG  	6 	/*Write single register*/
+#define MODBUS_FUNC_DIAG  		8 	/*Diagnostics (serial line)*/
+#define MODBUS_FUNC_WRMCOILS 	15  /*Write multiple coils*/
+#define MODBUS_FUNC_WRMREGS 	16  /*Write multiple registers*/
+#define MODBUS_FUNC_RDFILE 		20  /*Read file record*/
+#define MODBUS_FUNC_WRFILE 		21  /*Write file record*/
+#define MODBUS_FUNC_MSKWRREG 	22  /*Mask write register*/
+#define MODBUS_FUNC_RDWRMREGS 	23  /*Read/write multiple registers*/
 
 #define ARR2U16(a)					(uint16_t) (*(a) << 8) | *( (a)+1 )
 #define U162ARR(b,a)				*(a) = (uint8_t) ( ((b) >> 8) & 0xff ); *(a+1) = (uint8_t) ( (b) & 0xff )
 
-MBerror MB_PDU_Parser(uint8_t *pReqData, uint8_t *pRespData, uint16_t *pRespLen);
+#define MB_PDU_FUNC_NUM				128	/*Function codes number, higher codes are exceptions*/
+#define MB_PDU_MAX_LEN				253	/*Maximum PDU length*/
+#define MB_FILE_REF_TYPE			6	/*File record reference type*/
+#define MB_FILE_MAX_RECORD			9999	/*Maximum file record number*/
+
+/**
+ * @brief Function code handler. Gets the whole request PDU (starting with function code),
+ *        writes response PDU (up to respCap bytes) and its length. Exception response
+ *        is written by parser if handler returns exception code.
+ */
+typedef MBerror (*MB_PDU_Handler_t)(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap,
+                                    uint16_t *pRespLen);
+
+MBerror MB_PDU_Parser(uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap, uint16_t *pRespLen);
+#if MODBUS_PDU_CUSTOM_ENABLE
+MBerror MB_PDU_RegisterHandler(uint8_t fcode, MB_PDU_Handler_t handler);
+#endif
+
+#if MODBUS_FILE_ENABLE
+/*File records storage callbacks, implemented by application. Values are big-endian*/
+MBerror MBFileReadCallback(uint16_t file, uint16_t record, uint16_t num, uint8_t *pval);
+MBerror MBFileWriteCallback(uint16_t file, uint16_t record, uint16_t num, uint8_t *pval);
+#endif
 
 #endif /* MB_PDU_H_ */
@@ -0,0 +1,485 @@
+/*
+ * mb_regmap.c
+ *
+ * Registers store working on binary register map image (RegGen.py --bin).
+ * Replaces generated mb_regs.c when register map is loaded at runtime.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_regmap.h"
+#include <stddef.h>
+#if defined(__linux__)
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+extern uint16_t MBRTU_CRC(uint8_t *buf, uint16_t len);
+
+static const MBRegMap_Hdr_t *map_hdr = NULL;
+static const MBRegMap_Seg_t *map_seg = NULL;
+static const MBRegMap_Opt_t *map_opt = NULL;
+static const uint16_t *map_def = NULL;
+static uint16_t *map_val = NULL;
+#if defined(__linux__)
+static void *map_file = NULL;			/*Mapped file of MBRegMapOpen()*/
+static size_t map_file_size = 0;
+static uint16_t *map_file_val = NULL;	/*Values storage of mapped file*/
+#endif
+
+static MBerror MBRegMapFind(uint16_t addr, uint16_t num, uint16_t *index);
+static MBerror MBRegMapRead(uint16_t addr, uint16_t num, uint16_t **pval);
+static MBerror MBRegMapWrite(uint16_t addr, uint16_t num, uint8_t *pval);
+
+/**
+ * @brief               Checks binary register map image and sets it as registers map.
+ *                      Image is used in place and must stay valid while Modbus is running.
+ * @param image         Pointer to image (4 bytes aligned)
+ * @param size          Image size
+ * @param values        Pointer to registers values storage array
+ * @param values_num    Size of values storage array
+ * @return              Error code
+ */
+MBerror MBRegMapLoad(const void *image, uint32_t size, uint16_t *values, uint16_t values_num)
+{
+	const MBRegMap_Hdr_t *hdr = (const MBRegMap_Hdr_t *) image;
+	const MBRegMap_Seg_t *seg;
+	const uint16_t endian = 1;
+	uint32_t next = 0;
+	uint32_t i;
+
+	/*Image is used in place, so byte order must match*/
+	if ((image == NULL) || (values == NULL) || (*(const uint8_t *) &endian != 1) || ((uintptr_t) image & 3))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	if ((size < sizeof(MBRegMap_Hdr_t)) || (hdr->magic != MB_REGMAP_MAGIC) || (hdr->version != MB_REGMAP_VERSION) ||
+		(hdr->hdr_size < sizeof(MBRegMap_Hdr_t)) || (hdr->size > size) ||
+		(hdr->crc != MBRTU_CRC((uint8_t *) image, offsetof(MBRegMap_Hdr_t, crc))))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	if (((uint64_t) hdr->seg_off + (uint32_t) hdr->seg_num * sizeof(MBRegMap_Seg_t) > hdr->size) ||
+		((uint64_t) hdr->opt_off + (uint32_t) hdr->reg_num * sizeof(MBRegMap_Opt_t) > hdr->size) ||
+		((uint64_t) hdr->def_off + (uint32_t) hdr->reg_num * sizeof(uint16_t) > hdr->size) ||
+		((hdr->seg_off | hdr->opt_off | hdr->def_off) & 3) || (hdr->reg_num > values_num))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	/*Segments must be sorted, must not overlap and must fit address space and tables*/
+	seg = (const MBRegMap_Seg_t *) ((const uint8_t *) image + hdr->seg_off);
+
+	for (i = 0; i < hdr->seg_num; i++)
+	{
+		if ((seg[i].start < next) || ((uint32_t) seg[i].start + seg[i].num > 0x10000UL) ||
+			((uint32_t) seg[i].index + seg[i].num > hdr->reg_num))
+		{
+			return MODBUS_ERR_SYS;
+		}
+
+		next = (uint32_t) seg[i].start + seg[i].num;
+	}
+
+	MBRegLock();
+
+	map_hdr = hdr;
+	map_seg = seg;
+	map_opt = (const MBRegMap_Opt_t *) ((const uint8_t *) image + hdr->opt_off);
+	map_def = (const uint16_t *) ((const uint8_t *) image + hdr->def_off);
+	map_val = values;
+
+	for (i = 0; i < hdr->reg_num; i++)
+	{
+		map_val[i] = map_def[i];
+	}
+
+	MBRegUnlock();
+
+	return MODBUS_ERR_OK;
+}
+
+#if defined(__linux__)
+/**
+ * @brief       Maps binary register map file to memory and loads it
+ * @param path  Map file path
+ * @return      Error code
+ */
+MBerror MBRegMapOpen(const char *path)
+{
+	struct stat st;
+	const MBRegMap_Hdr_t *hdr;
+	uint16_t *values;
+	void *image;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(MBRegMap_Hdr_t)))
+	{
+		close(fd);
+		return MODBUS_ERR_SYS;
+	}
+
+	image = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (image == MAP_FAILED)
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	hdr = (const MBRegMap_Hdr_t *) image;
+	values = calloc(hdr->reg_num ? hdr->reg_num : 1, sizeof(uint16_t));
+
+	if ((values == NULL) || (MBRegMapLoad(image, (uint32_t) st.st_size, values, hdr->reg_num) != MODBUS_ERR_OK))
+	{
+		free(values);
+		munmap(image, (size_t) st.st_size);
+		return MODBUS_ERR_SYS;
+	}
+
+	/*Previous map isn't used after load*/
+	if (map_file != NULL)
+	{
+		free(map_file_val);
+		munmap(map_file, map_file_size);
+	}
+
+	map_file = image;
+	map_file_size = (size_t) st.st_size;
+	map_file_val = values;
+
+	return MODBUS_ERR_OK;
+}
+#endif /*__linux__*/
+
+/**
+ * @brief   Returns number of registers of loaded map
+ * @return  Registers number
+ */
+uint16_t MBRegMapRegNum(void)
+{
+	return (map_hdr != NULL) ? map_hdr->reg_num : 0;
+}
+
+/**
+ * @brief Registers initialization. Called on ModBus initialization
+ * @param arg
+ * @return Error code
+ */
+MBerror MBRegInit(void *arg)
+{
+	(void) arg;
+
+	return (map_hdr != NULL) ? MODBUS_ERR_OK : MODBUS_ERR_SYS;
+}
+
+/**
+ * @brief Modbus registers read callback
+ * @param addr First register address
+ * @param num Registers number
+ * @param pval Pointer to registers values pointer storage
+ * @return Error code
+ */
+MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **pval)
+{
+	MBerror err;
+
+	MBRegLock();
+	err = MBRegMapRead(addr, num, pval);
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Modbus registers write callback. Registers are written only
+ *        if all of them are writable and values are in range
+ * @param addr First register address
+ * @param num Registers number
+ * @param pval Pointer to registers values (big-endian)
+ * @return Error code
+ */
+MBerror MBRegsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	MBerror err;
+
+	MBRegLock();
+	err = MBRegMapWrite(addr, num, pval);
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Modbus registers read/write callback (function 23).
+ *        Registers are written and then read under one registers lock.
+ *        Read range is checked before write, so failed request doesn't change registers
+ * @param rd_addr First register to read address
+ * @param rd_num Registers to read number
+ * @param rd_val Pointer to read registers values storage (big-endian), filled under the lock
+ * @param wr_addr First register to write address
+ * @param wr_num Registers to write number
+ * @param wr_val Pointer to registers values to write (big-endian)
+ * @return Error code
+ */
+MBerror MBRegsReadWriteCallback(uint16_t rd_addr, uint16_t rd_num, uint8_t *rd_val,
+								uint16_t wr_addr, uint16_t wr_num, uint8_t *wr_val)
+{
+	MBerror err;
+	uint16_t *pval = NULL;
+	uint16_t i;
+
+	MBRegLock();
+
+	/*Read values storage stays in place, so it gets written values too*/
+	err = MBRegMapRead(rd_addr, rd_num, &pval);
+
+	if (err == MODBUS_ERR_OK)
+	{
+		err = MBRegMapWrite(wr_addr, wr_num, wr_val);
+	}
+
+	if (err == MODBUS_ERR_OK)
+	{
+		for (i = 0; i < rd_num; i++)
+		{
+			U162ARR(pval[i], &rd_val[2*i]);
+		}
+	}
+
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Modbus register mask write callback (function 22)
+ * @param addr Register address
+ * @param and_mask AND mask
+ * @param or_mask OR mask
+ * @return Error code
+ */
+MBerror MBRegMaskWriteCallback(uint16_t addr, uint16_t and_mask, uint16_t or_mask)
+{
+	uint16_t index, val;
+	uint8_t buf[2];
+	MBerror err;
+
+	MBRegLock();
+
+	err = MBRegMapFind(addr, 1, &index);
+
+	if (err == MODBUS_ERR_OK)
+	{
+		val = (map_val[index] & and_mask) | (or_mask & ~and_mask);
+		U162ARR(val, buf);
+
+		err = MBRegMapWrite(addr, 1, buf);
+	}
+
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Application function for register value writing
+ * @param addr Register address
+ * @param val Register value
+ * @param err Pointer to error code storage variable
+ */
+void MBRegSetValue(uint16_t addr, uint16_t val, MBerror *err)
+{
+	uint16_t index;
+
+	MBRegLock();
+
+	*err = MBRegMapFind(addr, 1, &index);
+
+	if (*err == MODBUS_ERR_OK)
+	{
+		map_val[index] = val;
+	}
+
+	MBRegUnlock();
+}
+
+/**
+ * @brief Application function for register value reading
+ * @param addr Register address
+ * @param err Pointer to error code storage variable
+ * @return Register value
+ */
+uint16_t MBRegGetValue(uint16_t addr, MBerror *err)
+{
+	uint16_t index;
+	uint16_t retval = 0;
+
+	MBRegLock();
+
+	*err = MBRegMapFind(addr, 1, &index);
+
+	if (*err == MODBUS_ERR_OK)
+	{
+		retval = map_val[index];
+	}
+
+	MBRegUnlock();
+
+	return retval;
+}
+
+/**
+ * @brief       Looks for segment containing the whole registers range
+ * @param addr  First register address
+ * @param num   Registers number
+ * @param index Pointer to first register index storage variable
+ * @return      Error code
+ */
+static MBerror MBRegMapFind(uint16_t addr, uint16_t num, uint16_t *index)
+{
+	uint32_t lo = 0;
+	uint32_t hi;
+
+	if ((map_hdr == NULL) || (num == 0))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	hi = map_hdr->seg_num;
+
+	/*Look for last segment starting at or before addr*/
+	while (lo < hi)
+	{
+		uint32_t mid = (lo + hi) / 2;
+
+		if (map_seg[mid].start <= addr)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	if ((lo == 0) || ((uint32_t) addr + num > (uint32_t) map_seg[lo - 1].start + map_seg[lo - 1].num))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	*index = map_seg[lo - 1].index + (addr - map_seg[lo - 1].start);
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief Registers read. Registers lock must be taken
+ * @param addr First register address
+ * @param num Registers number
+ * @param pval Pointer to registers values pointer storage
+ * @return Error code
+ */
+static MBerror MBRegMapRead(uint16_t addr, uint16_t num, uint16_t **pval)
+{
+	uint16_t index, i;
+	MBerror err;
+
+	err = MBRegMapFind(addr, num, &index);
+
+	for (i = 0; (err == MODBUS_ERR_OK) && (i < num); i++)
+	{
+		if (!(map_opt[index + i].opt & MB_REGMAP_OPT_RD))
+		{
+			err = MODBUS_ERR_ILLEGADDR;
+		}
+	}
+
+	if (err == MODBUS_ERR_OK)
+	{
+		*pval = &map_val[index];
+	}
+
+	return err;
+}
+
+/**
+ * @brief Registers write. Registers lock must be taken
+ * @param addr First register address
+ * @param num Registers number
+ * @param pval Pointer to registers values (big-endian)
+ * @return Error code
+ */
+static MBerror MBRegMapWrite(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	const MBRegMap_Opt_t *opt;
+	uint16_t index, i, val;
+	MBerror err;
+
+	err = MBRegMapFind(addr, num, &index);
+
+	for (i = 0; (err == MODBUS_ERR_OK) && (i < num); i++)
+	{
+		opt = &map_opt[index + i];
+		val = ARR2U16(&pval[2*i]);
+
+		if (!(opt->opt & MB_REGMAP_OPT_WR))
+		{
+			err = MODBUS_ERR_ILLEGADDR;
+		}
+		else if ((val < opt->min) || (val > opt->max))
+		{
+			err = MODBUS_ERR_ILLEGVAL;
+		}
+	}
+
+	if (err == MODBUS_ERR_OK)
+	{
+		for (i = 0; i < num; i++)
+		{
+			map_val[index + i] = ARR2U16(&pval[2*i]);
+		}
+
+		MBRegsUpdated(addr, num, &map_val[index]);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Registers range update callback. Called once per write request
+ *        with registers lock taken
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to new registers values
+ */
+__weak void MBRegsUpdated(uint16_t addr, uint16_t num, uint16_t *pval)
+{
+
+}
+
+/**
+ * @brief Locks access to registers
+ */
+__weak void MBRegLock(void)
+{
+	/*Take mutex here*/
+}
+
+/**
+ * @brief Unlocks access to registers
+ */
+__weak void MBRegUnlock(void)
+{
+	/*Give mutex here*/
+}
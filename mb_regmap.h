@@ -0,0 +1,78 @@
+/*
+ * mb_regmap.h
+ *
+ * Registers store working on binary register map image (RegGen.py --bin).
+ * Replaces generated mb_regs.c when register map is loaded at runtime.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_REGMAP_H_
+#define MB_REGMAP_H_
+
+#include "mb_pdu.h"
+#include <stdint.h>
+
+#define MB_REGMAP_MAGIC			0x4D52424DUL	/*"MBRM"*/
+#define MB_REGMAP_VERSION		1
+
+#define MB_REGMAP_OPT_RD		0x01	/*Register is readable by Modbus (REG_OPT_UR)*/
+#define MB_REGMAP_OPT_WR		0x02	/*Register is writable by Modbus (REG_OPT_UWR)*/
+
+/**
+ * @brief Binary map image layout. All fields are little-endian, tables are 4 bytes aligned.
+ *        Image is used in place (flash or memory mapped file), only values are kept in RAM.
+ */
+typedef struct {
+	uint32_t magic;				/*!< MB_REGMAP_MAGIC */
+	uint16_t version;			/*!< MB_REGMAP_VERSION */
+	uint16_t hdr_size;			/*!< Header size */
+	uint32_t size;				/*!< Image size */
+	uint16_t reg_num;			/*!< Registers number (options/defaults tables length) */
+	uint16_t seg_num;			/*!< Segments number */
+	uint32_t seg_off;			/*!< Segments index offset */
+	uint32_t opt_off;			/*!< Options table offset */
+	uint32_t def_off;			/*!< Default values table offset */
+	uint16_t reserved;
+	uint16_t crc;				/*!< CRC of header without this field */
+} MBRegMap_Hdr_t;
+
+/**
+ * @brief Segment of contiguous registers addresses. Segments are sorted by start address
+ */
+typedef struct {
+	uint16_t start;				/*!< First register address */
+	uint16_t num;				/*!< Registers number */
+	uint16_t index;				/*!< Index of first register in options/defaults/values tables */
+	uint16_t reserved;
+} MBRegMap_Seg_t;
+
+/**
+ * @brief Register options
+ */
+typedef struct {
+	uint8_t opt;				/*!< REG_OPT_x */
+	uint8_t reserved;
+	uint16_t min;
+	uint16_t max;
+} MBRegMap_Opt_t;
+
+MBerror MBRegMapLoad(const void *image, uint32_t size, uint16_t *values, uint16_t values_num);
+#if defined(__linux__)
+MBerror MBRegMapOpen(const char *path);
+#endif
+uint16_t MBRegMapRegNum(void);
+
+MBerror MBRegInit(void *arg);
+MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **pval);
+MBerror MBRegsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval);
+MBerror MBRegsReadWriteCallback(uint16_t rd_addr, uint16_t rd_num, uint8_t *rd_val,
+								uint16_t wr_addr, uint16_t wr_num, uint8_t *wr_val);
+MBerror MBRegMaskWriteCallback(uint16_t addr, uint16_t and_mask, uint16_t or_mask);
+void MBRegSetValue(uint16_t addr, uint16_t val, MBerror *err);
+uint16_t MBRegGetValue(uint16_t addr, MBerror *err);
+void MBRegsUpdated(uint16_t addr, uint16_t num, uint16_t *pval);
+void MBRegLock(void);
+void MBRegUnlock(void);
+
+#endif /* MB_REGMAP_H_ */
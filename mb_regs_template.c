@@ -5,6 +5,11 @@
  */
 
 #include "mb_regs.h"
+#include "mb_bitmap.h"
+#if MODBUS_NVM_ENABLE
+#include "mb_nvm.h"
+#endif
+#include <string.h>
 
 #define REG_READ		0x01
 #define REG_WRITE		0x02
@@ -19,28 +24,212 @@ typedef struct {
 	uint16_t def;
 } RegOpt_t;
 
+typedef union {
+	int64_t i;
+	uint64_t u;
+	float f;
+} RegLim_t;
+
+typedef struct {
+	uint16_t addr;
+	uint16_t size;
+	uint8_t type;
+	uint8_t order;
+	RegLim_t min;
+	RegLim_t max;
+} RegTyped_t;
+
 /**
  * @brief Registers options and min/max/def values
  */
 static const RegOpt_t MBRegOpt[REG_NUM] = {
 	{REG_STATUS_OPT, REG_STATUS_MIN, REG_STATUS_MAX, REG_STATUS_DEF},
 	{REG_VALUE1_OPT, REG_VALUE1_MIN, REG_VALUE1_MAX, REG_VALUE1_DEF},
-	{REG_VALUE2_OPT, REG_VALUE2_MIN, REG_VALUE2_MAX, REG_VALUE2_DEF}
+	{REG_VALUE2_OPT, REG_VALUE2_MIN, REG_VALUE2_MAX, REG_VALUE2_DEF},
+	{REG_SETPOINT_OPT, 0, 0xFFFF, 0x41A4},
+	{REG_SETPOINT_OPT, 0, 0xFFFF, 0x0000},
+	{REG_UPTIME_OPT, REG_UPTIME_MIN, REG_UPTIME_MAX, REG_UPTIME_DEF}
 };
 
 /**
- * @brief Registers array initialization with default values
+ * @brief Registers array initialization with default values.
+ *        Global to be accessed directly by mb_regs.hpp accessors
  */
-static uint16_t MBRegVal[REG_NUM] = {
+uint16_t MBRegVal[REG_NUM] = {
 	REG_STATUS_DEF,
 	REG_VALUE1_DEF,
-	REG_VALUE2_DEF
+	REG_VALUE2_DEF,
+	0x41A4,
+	0x0000,
+	REG_UPTIME_DEF
+};
+
+/**
+ * @brief Registers read/write permission bitmaps (bit per register)
+ */
+static const uint32_t MBRegRdMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x0000003D
+};
+
+static const uint32_t MBRegWrMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x0000001E
+};
+
+/**
+ * @brief Registers without min/max restriction (bit per register)
+ */
+static const uint32_t MBRegNoLimMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x00000038
+};
+
+#if REG_TYPED_NUM > 0
+/**
+ * @brief Typed values (signed and multi-register) sorted by address
+ */
+static const RegTyped_t MBRegTyped[REG_TYPED_NUM] = {
+	{REG_SETPOINT_ADDR, REG_SETPOINT_SIZE, REG_SETPOINT_TYPE, REG_SETPOINT_ORDER, {.f = REG_SETPOINT_MIN}, {.f = REG_SETPOINT_MAX}}
+};
+
+/**
+ * @brief Registers belonging to typed values (bit per register)
+ */
+static const uint32_t MBRegTypedMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x00000018
+};
+#endif /*REG_TYPED_NUM*/
+
+#if REG_COMPUTED_NUM > 0
+typedef struct {
+	uint16_t addr;
+	uint16_t age;				/*Value memoization age, ms. 0 - compute on every read*/
+	uint16_t (*hook)(void);
+} RegComputed_t;
+
+/**
+ * @brief Computed registers sorted by address
+ */
+static const RegComputed_t MBRegComputed[REG_COMPUTED_NUM] = {
+	{REG_UPTIME_ADDR, REG_UPTIME_AGE, MBRegCompute_UPTIME}
+};
+
+/**
+ * @brief Computed registers (bit per register)
+ */
+static const uint32_t MBRegComputedMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x00000020
+};
+
+/**
+ * @brief Time of last computation and computed values validity (bit per computed register)
+ */
+static uint32_t MBRegComputedTick[REG_COMPUTED_NUM];
+static uint32_t MBRegComputedValid[MB_BITMAP_WORDS(REG_COMPUTED_NUM)];
+#endif /*REG_COMPUTED_NUM*/
+
+#if MODBUS_NVM_ENABLE
+/**
+ * @brief Non-volatile registers (bit per register)
+ */
+static const uint32_t MBRegNvMap[MB_BITMAP_WORDS(REG_NUM)] = {
+	0x0000001A
+};
+
+/**
+ * @brief Non-volatile registers changed since last storage flush
+ */
+static uint32_t MBRegNvPend[MB_BITMAP_WORDS(REG_NUM)];
+#endif /*MODBUS_NVM_ENABLE*/
+
+#define COIL_WORDS		((COIL_NUM > 0) ? MB_BITMAP_WORDS(COIL_NUM) : 1)
+#define DINP_WORDS		((DINP_NUM > 0) ? MB_BITMAP_WORDS(DINP_NUM) : 1)
+
+#if MODBUS_COILS_ENABLE
+/**
+ * @brief Coils values initialization with default values (bit per coil)
+ */
+static uint32_t MBCoilVal[COIL_WORDS] = {
+	0x00000009
+};
+
+/**
+ * @brief Coils write permission bitmap (bit per coil)
+ */
+static const uint32_t MBCoilWrMap[COIL_WORDS] = {
+	0x00000003
+};
+#endif /*MODBUS_COILS_ENABLE*/
+
+#if MODBUS_DINP_ENABLE
+/**
+ * @brief Discrete inputs values initialization with default values (bit per input)
+ */
+static uint32_t MBInputVal[DINP_WORDS] = {
+	0x00000000
 };
+#endif /*MODBUS_DINP_ENABLE*/
 
 static uint16_t regs_inited = 0;
 
-static uint32_t MBRegCheckOp(uint16_t addr, uint8_t op);
+#if MODBUS_REGS_DIRTY_ENABLE
+typedef struct {
+	uint16_t addr;
+	uint16_t num;
+	MBRegChangesCb_t cb;
+	void *arg;
+} RegSubscr_t;
+
+/**
+ * @brief Changed registers bitmap (bit per register)
+ */
+static uint32_t MBRegDirty[MB_BITMAP_WORDS(REG_NUM)];
+
+/**
+ * @brief Registers changes subscribers
+ */
+static RegSubscr_t MBRegSubscr[MODBUS_REGS_SUBSCR_NUM];
+#endif /*MODBUS_REGS_DIRTY_ENABLE*/
+
+#if MODBUS_REGS_UPDQ_ENABLE
+typedef struct {
+	uint16_t addr;
+	uint16_t val;
+} RegUpd_t;
+
+/**
+ * @brief Pending registers updates queue. Single producer (write requests
+ *        under registers lock), single consumer (MBRegProcessUpdates)
+ */
+static RegUpd_t MBRegUpdQ[MODBUS_REGS_UPDQ_LEN];
+static volatile uint16_t MBRegUpdQHead = 0;
+static volatile uint16_t MBRegUpdQTail = 0;
+
+/**
+ * @brief Registers updated while the queue was full (bit per register).
+ *        Queue isn't used until they are resynced by MBRegProcessUpdates()
+ */
+static uint32_t MBRegUpdLost[MB_BITMAP_WORDS(REG_NUM)];
+static volatile uint8_t MBRegUpdOvf = 0;
+#endif /*MODBUS_REGS_UPDQ_ENABLE*/
+
+static MBerror MBRegCheckRead(uint16_t addr, uint16_t num);
+static MBerror MBRegRead(uint16_t addr, uint16_t num, uint16_t **pval);
+static MBerror MBRegWrite(uint16_t addr, uint16_t num, uint8_t *pval);
+static void MBRegStore(uint16_t addr, uint16_t val);
+static void MBRegNotify(uint16_t addr, uint16_t num);
+#if MODBUS_REGS_UPDQ_ENABLE
+static uint16_t MBRegUpdQDrain(void);
+static uint16_t MBRegUpdResync(void);
+#endif
 static uint32_t MBRegCheckVal(uint16_t addr, uint16_t val);
+static MBerror MBRegCheckTyped(uint16_t addr, uint16_t num, uint8_t *pval);
+static uint64_t MBRegGetWords(uint16_t addr, uint16_t size, uint8_t order, MBerror *err);
+static void MBRegSetWords(uint16_t addr, uint16_t size, uint8_t order, uint64_t val, MBerror *err);
+#if MODBUS_REGS_ATOMIC_WR
+static MBerror MBRegCheckWrite(uint16_t addr, uint16_t num, uint8_t *pval);
+#endif
+#if REG_COMPUTED_NUM > 0
+static void MBRegCompute(uint16_t addr, uint16_t num);
+#endif
 
 /**
  * @brief Registers initialization. Called on ModBus initialization
@@ -53,9 +242,19 @@ MBerror MBRegInit(void *arg)
 
 	if (!regs_inited)
 	{
+#if MODBUS_NVM_ENABLE
+		/*Restore non-volatile registers from storage journal*/
+		if (MBNvmRestore() != MODBUS_ERR_OK)
+		{
+			return MODBUS_ERR_SYS;
+		}
+#endif
+
 		/* USER CODE BEGIN */
 
 		/* USER CODE END */
+
+		regs_inited = 1;
 	}
 
 	return MODBUS_ERR_OK;
@@ -70,32 +269,76 @@ MBerror MBRegInit(void *arg)
  */
 MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **pval)
 {
-	MBerror err = MODBUS_ERR_OK;
+	MBerror err;
+
+	MBRegLock();
+	err = MBRegRead(addr, num, pval);
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Function 06/16 - Preset Single/Multiple Registers Callback
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to array containing registers values
+ * @return Error code
+ */
+MBerror MBRegsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	MBerror err;
+
+	MBRegLock();
+	err = MBRegWrite(addr, num, pval);
+	MBRegUnlock();
+
+	return err;
+}
+
+/**
+ * @brief Function 23 - Read/Write Multiple Registers Callback.
+ *        Write is done before read under the same registers lock,
+ *        so read values include the written ones. Read range is checked
+ *        before write, so failed request doesn't change registers.
+ *        Read values are copied under the lock too.
+ * @param rd_addr Registers to read start address
+ * @param rd_num Registers to read number
+ * @param rd_val Pointer to array will contain read registers values (big-endian)
+ * @param wr_addr Registers to write start address
+ * @param wr_num Registers to write number
+ * @param wr_val Pointer to array containing registers values
+ * @return Error code
+ */
+MBerror MBRegsReadWriteCallback(uint16_t rd_addr, uint16_t rd_num, uint8_t *rd_val,
+								uint16_t wr_addr, uint16_t wr_num, uint8_t *wr_val)
+{
+	MBerror err;
+	uint16_t *pval = NULL;
 	uint16_t i;
 
 	MBRegLock();
 
-	MODBUS_TRACE("Func. 03/04 (Read regs). Addr: %d, Num: %d\r\n", addr, num);
+	MODBUS_TRACE("Func. 23 (Read/Write regs). Rd: %d/%d, Wr: %d/%d\r\n", rd_addr, rd_num, wr_addr, wr_num);
 
-	if ((addr < REG_NUM) && (addr + num <= REG_NUM))
+	err = MBRegCheckRead(rd_addr, rd_num);
+
+	if (err == MODBUS_ERR_OK)
 	{
-		for (i = 0; i < num; i++)
-		{
-			if (!MBRegCheckOp(addr + i, REG_READ))
-			{
-				err = MODBUS_ERR_ILLEGADDR;
-				break;
-			}
-		}
+		err = MBRegWrite(wr_addr, wr_num, wr_val);
 	}
-	else
+
+	if (err == MODBUS_ERR_OK)
 	{
-		err = MODBUS_ERR_ILLEGADDR;
+		err = MBRegRead(rd_addr, rd_num, &pval);
 	}
 
 	if (err == MODBUS_ERR_OK)
 	{
-		*pval = &MBRegVal[addr];
+		for (i = 0; i < rd_num; i++)
+		{
+			U162ARR(pval[i], &rd_val[2*i]);
+		}
 	}
 
 	MBRegUnlock();
@@ -104,50 +347,29 @@ MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **pval)
 }
 
 /**
- * @brief Function 06/16 - Preset Single/Multiple Registers Callback
- * @param addr Registers start address
- * @param num Registers number
- * @param pval Pointer to array containing registers values
+ * @brief Function 22 - Mask Write Register Callback.
+ *        Register = (Register AND and_mask) OR (or_mask AND NOT and_mask)
+ * @param addr Register address
+ * @param and_mask AND mask
+ * @param or_mask OR mask
  * @return Error code
  */
-MBerror MBRegsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+MBerror MBRegMaskWriteCallback(uint16_t addr, uint16_t and_mask, uint16_t or_mask)
 {
-	MBerror err = MODBUS_ERR_OK;
-	uint32_t i;
+	MBerror err = MODBUS_ERR_ILLEGADDR;
+	uint16_t val;
+	uint8_t buf[2];
 
 	MBRegLock();
 
-	MODBUS_TRACE("Func. 16 (Preset regs). Addr: %d, Num: %d\r\n", addr, num);
+	MODBUS_TRACE("Func. 22 (Mask write reg). Addr: %d\r\n", addr);
 
-	if ((addr < REG_NUM) && (addr + num <= REG_NUM))
+	if (addr < REG_NUM)
 	{
-		for (i = 0; i < num; i++)
-		{
-			/*Check permission & value*/
-			if (MBRegCheckOp(addr, REG_WRITE))
-			{
-				if (MBRegCheckVal(addr, ARR2U16(pval)))
-				{
-					MBRegVal[addr] = ARR2U16(pval);
-					MBRegUpdated(addr, ARR2U16(pval));
-				}
-				else
-				{
-					err = MODBUS_ERR_ILLEGVAL;
-				}
-			}
-			else
-			{
-				err = MODBUS_ERR_ILLEGADDR;
-			}
+		val = (MBRegVal[addr] & and_mask) | (or_mask & ~and_mask);
+		U162ARR(val, buf);
 
-			addr++;
-			pval += 2;
-		}
-	}
-	else
-	{
-		err = MODBUS_ERR_ILLEGADDR;
+		err = MBRegWrite(addr, 1, buf);
 	}
 
 	MBRegUnlock();
@@ -168,7 +390,7 @@ void MBRegSetValue(uint16_t addr, uint16_t val, MBerror *err)
 	if (addr < REG_NUM)
 	{
 		*err = MODBUS_ERR_OK;
-		MBRegVal[addr] = val;
+		MBRegStore(addr, val);
 	}
 	else
 	{
@@ -180,6 +402,7 @@ void MBRegSetValue(uint16_t addr, uint16_t val, MBerror *err)
 
 /**
  * @brief Application function for register value reading
+ *        Computed register is refreshed by its read hook unless memoized value is fresh
  * @param addr Register address
  * @param err Pointer to error code storage variable
  * @return Register value
@@ -192,6 +415,9 @@ uint16_t MBRegGetValue(uint16_t addr, MBerror *err)
 	if (addr < REG_NUM)
 	{
 		*err = MODBUS_ERR_OK;
+#if REG_COMPUTED_NUM > 0
+		MBRegCompute(addr, 1);
+#endif
 		retval = MBRegVal[addr];
 	}
 	else
@@ -206,34 +432,1178 @@ uint16_t MBRegGetValue(uint16_t addr, MBerror *err)
 }
 
 /**
- * @brief Checks register operation permission
- * @param addr Register address
- * @param op Operation code
- * @return Returns 1 if permission available
+ * @brief Application function for 32-bit value reading
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
+ * @param err Pointer to error code storage variable
+ * @return Value
  */
-static uint32_t MBRegCheckOp(uint16_t addr, uint8_t op)
+uint32_t MBRegGetU32(uint16_t addr, uint8_t order, MBerror *err)
 {
-	return MBRegOpt[addr].opt & op;
+	return (uint32_t) MBRegGetWords(addr, 2, order, err);
 }
 
 /**
- * @brief Checks register value restrictions
- * @param addr Register address
+ * @brief Application function for 32-bit value writing
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
  * @param val Value
- * @return Returns 1 if permission available
+ * @param err Pointer to error code storage variable
  */
-static uint32_t MBRegCheckVal(uint16_t addr, uint16_t val)
+void MBRegSetU32(uint16_t addr, uint8_t order, uint32_t val, MBerror *err)
 {
-	return (val >= MBRegOpt[addr].min) & (val <= MBRegOpt[addr].max);
+	MBRegSetWords(addr, 2, order, val, err);
 }
 
 /**
- * @brief Register update callback
+ * @brief Application function for 64-bit value reading
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
+ * @param err Pointer to error code storage variable
+ * @return Value
  */
-__weak void MBRegUpdated(uint16_t addr, uint16_t val)
+uint64_t MBRegGetU64(uint16_t addr, uint8_t order, MBerror *err)
+{
+	return MBRegGetWords(addr, 4, order, err);
+}
+
+/**
+ * @brief Application function for 64-bit value writing
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
+ * @param val Value
+ * @param err Pointer to error code storage variable
+ */
+void MBRegSetU64(uint16_t addr, uint8_t order, uint64_t val, MBerror *err)
+{
+	MBRegSetWords(addr, 4, order, val, err);
+}
+
+/**
+ * @brief Application function for float value reading
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
+ * @param err Pointer to error code storage variable
+ * @return Value
+ */
+float MBRegGetF32(uint16_t addr, uint8_t order, MBerror *err)
+{
+	uint32_t raw = (uint32_t) MBRegGetWords(addr, 2, order, err);
+	float val;
+
+	memcpy(&val, &raw, sizeof(val));
+
+	return val;
+}
+
+/**
+ * @brief Application function for float value writing
+ * @param addr First register address
+ * @param order Words order (REG_ORDER_MSW/REG_ORDER_LSW)
+ * @param val Value
+ * @param err Pointer to error code storage variable
+ */
+void MBRegSetF32(uint16_t addr, uint8_t order, float val, MBerror *err)
+{
+	uint32_t raw;
+
+	memcpy(&raw, &val, sizeof(raw));
+
+	MBRegSetWords(addr, 2, order, raw, err);
+}
+
+/**
+ * @brief Application function for string reading. Two chars per register,
+ *        first char in high byte.
+ * @param addr First register address
+ * @param size Registers number
+ * @param str Pointer to string buffer (2*size + 1 bytes)
+ * @param err Pointer to error code storage variable
+ */
+void MBRegGetStr(uint16_t addr, uint16_t size, char *str, MBerror *err)
+{
+	uint32_t i;
+
+	MBRegLock();
+
+	if ((addr < REG_NUM) && (addr + size <= REG_NUM))
+	{
+		*err = MODBUS_ERR_OK;
+
+		for (i = 0; i < size; i++)
+		{
+			str[2*i] = (char) (MBRegVal[addr + i] >> 8);
+			str[2*i + 1] = (char) (MBRegVal[addr + i] & 0xFF);
+		}
+
+		str[2*size] = '\0';
+	}
+	else
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+		str[0] = '\0';
+	}
+
+	MBRegUnlock();
+}
+
+/**
+ * @brief Application function for string writing. Unused registers are
+ *        filled with zeros.
+ * @param addr First register address
+ * @param size Registers number
+ * @param str String
+ * @param err Pointer to error code storage variable
+ */
+void MBRegSetStr(uint16_t addr, uint16_t size, const char *str, MBerror *err)
+{
+	uint32_t i;
+
+	MBRegLock();
+
+	if ((addr < REG_NUM) && (addr + size <= REG_NUM))
+	{
+		*err = MODBUS_ERR_OK;
+
+		for (i = 0; i < size; i++)
+		{
+			uint16_t val = 0;
+
+			if (*str != '\0')
+			{
+				val = (uint16_t) ((uint8_t) *str++ << 8);
+
+				if (*str != '\0')
+				{
+					val |= (uint8_t) *str++;
+				}
+			}
+
+			MBRegStore(addr + i, val);
+		}
+	}
+	else
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegUnlock();
+}
+
+#if MODBUS_COILS_ENABLE
+/**
+ * @brief Modbus coils read callback
+ * @param addr First coil address
+ * @param num Coils number
+ * @param pval Packed coils values storage ((num + 7) / 8 bytes, first coil in LSB of first byte)
+ * @return Error code
+ */
+MBerror MBCoilsReadCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	if ((num == 0) || (num > 2000) || ((uint32_t) addr + num > COIL_NUM))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	/*Values are copied under the lock, the storage is owned by the caller*/
+	MBRegLock();
+	MBBitmapExtract(MBCoilVal, addr, num, pval);
+	MBRegUnlock();
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief Modbus coils write callback
+ * @param addr First coil address
+ * @param num Coils number
+ * @param pval Pointer to packed coils values (first coil in LSB of first byte)
+ * @return Error code
+ */
+MBerror MBCoilsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	if ((num == 0) || ((uint32_t) addr + num > COIL_NUM) || !MBBitmapTest(MBCoilWrMap, addr, num))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegLock();
+	MBBitmapInsert(MBCoilVal, addr, num, pval);
+	MBCoilsUpdated(addr, num);
+	MBRegUnlock();
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief Application function for coil value reading
+ * @param addr Coil address
+ * @param err Pointer to error code storage variable
+ * @return Coil value (0/1)
+ */
+uint8_t MBCoilGet(uint16_t addr, MBerror *err)
+{
+#if COIL_NUM > 0
+	if (addr >= COIL_NUM)
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+		return 0;
+	}
+
+	*err = MODBUS_ERR_OK;
+
+	return (uint8_t) MB_BITMAP_BIT(MBCoilVal, addr);
+#else
+	(void) addr;
+	*err = MODBUS_ERR_ILLEGADDR;
+
+	return 0;
+#endif
+}
+
+/**
+ * @brief Application function for coil value writing
+ * @param addr Coil address
+ * @param val Coil value (0/1)
+ * @param err Pointer to error code storage variable
+ */
+void MBCoilSet(uint16_t addr, uint8_t val, MBerror *err)
+{
+#if COIL_NUM > 0
+	if (addr >= COIL_NUM)
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+		return;
+	}
+
+	MBRegLock();
+
+	if (val)
+	{
+		MB_BITMAP_SETBIT(MBCoilVal, addr);
+	}
+	else
+	{
+		MB_BITMAP_CLRBIT(MBCoilVal, addr);
+	}
+
+	MBRegUnlock();
+
+	*err = MODBUS_ERR_OK;
+#else
+	(void) addr;
+	(void) val;
+	*err = MODBUS_ERR_ILLEGADDR;
+#endif
+}
+#endif /*MODBUS_COILS_ENABLE*/
+
+#if MODBUS_DINP_ENABLE
+/**
+ * @brief Modbus discrete inputs read callback
+ * @param addr First input address
+ * @param num Inputs number
+ * @param pval Packed inputs values storage ((num + 7) / 8 bytes, first input in LSB of first byte)
+ * @return Error code
+ */
+MBerror MBInputsReadCallback(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	if ((num == 0) || (num > 2000) || ((uint32_t) addr + num > DINP_NUM))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegLock();
+	MBBitmapExtract(MBInputVal, addr, num, pval);
+	MBRegUnlock();
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief Application function for discrete input value reading
+ * @param addr Input address
+ * @param err Pointer to error code storage variable
+ * @return Input value (0/1)
+ */
+uint8_t MBInputGet(uint16_t addr, MBerror *err)
+{
+#if DINP_NUM > 0
+	if (addr >= DINP_NUM)
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+		return 0;
+	}
+
+	*err = MODBUS_ERR_OK;
+
+	return (uint8_t) MB_BITMAP_BIT(MBInputVal, addr);
+#else
+	(void) addr;
+	*err = MODBUS_ERR_ILLEGADDR;
+
+	return 0;
+#endif
+}
+
+/**
+ * @brief Application function for discrete input value writing
+ * @param addr Input address
+ * @param val Input value (0/1)
+ * @param err Pointer to error code storage variable
+ */
+void MBInputSet(uint16_t addr, uint8_t val, MBerror *err)
+{
+#if DINP_NUM > 0
+	if (addr >= DINP_NUM)
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+		return;
+	}
+
+	MBRegLock();
+
+	if (val)
+	{
+		MB_BITMAP_SETBIT(MBInputVal, addr);
+	}
+	else
+	{
+		MB_BITMAP_CLRBIT(MBInputVal, addr);
+	}
+
+	MBRegUnlock();
+
+	*err = MODBUS_ERR_OK;
+#else
+	(void) addr;
+	(void) val;
+	*err = MODBUS_ERR_ILLEGADDR;
+#endif
+}
+#endif /*MODBUS_DINP_ENABLE*/
+
+#if MODBUS_REGS_UPDQ_ENABLE
+/**
+ * @brief Processes pending registers updates out of Modbus requests context.
+ *        Calls MBRegsUpdated() for every run of consecutive registers.
+ *        Updates dropped on queue overflow are delivered after queued ones
+ *        with current registers values.
+ *        Call from application task, registers lock must not be taken.
+ * @return Number of processed updates
+ */
+uint16_t MBRegProcessUpdates(void)
+{
+	uint16_t cnt = MBRegUpdQDrain();
+
+	if (MBRegUpdOvf)
+	{
+		/*Nothing is queued after overflow, so the rest of queue is older than lost updates*/
+		cnt += MBRegUpdQDrain();
+		cnt += MBRegUpdResync();
+	}
+
+	return cnt;
+}
+
+/**
+ * @brief Delivers queued updates
+ * @return Number of processed updates
+ */
+static uint16_t MBRegUpdQDrain(void)
+{
+	uint16_t vals[MODBUS_REGS_UPDQ_LEN];
+	uint16_t tail = MBRegUpdQTail;
+	uint16_t head = MBRegUpdQHead;
+	uint16_t start = 0;
+	uint16_t num = 0;
+	uint16_t cnt = 0;
+
+	/*Entries before head are completely written*/
+	MB_MEM_BARRIER();
+
+	while (tail != head)
+	{
+		RegUpd_t *upd = &MBRegUpdQ[tail & (MODBUS_REGS_UPDQ_LEN - 1)];
+
+		if ((num > 0) && (upd->addr != start + num))
+		{
+			MBRegsUpdated(start, num, vals);
+			num = 0;
+		}
+
+		if (num == 0)
+		{
+			start = upd->addr;
+		}
+
+		vals[num++] = upd->val;
+		tail++;
+		cnt++;
+	}
+
+	/*Entries are copied, release them to producer*/
+	MB_MEM_BARRIER();
+	MBRegUpdQTail = tail;
+
+	if (num > 0)
+	{
+		MBRegsUpdated(start, num, vals);
+	}
+
+	return cnt;
+}
+
+/**
+ * @brief Delivers current values of registers updated while the queue was full.
+ *        Values are copied under registers lock, the queue is used again when
+ *        all of them are delivered.
+ * @return Number of processed updates
+ */
+static uint16_t MBRegUpdResync(void)
+{
+	uint16_t vals[MODBUS_REGS_UPDQ_LEN];
+	uint16_t from = 0;
+	uint16_t start, num, i;
+	uint16_t cnt = 0;
+
+	while (1)
+	{
+		MBRegLock();
+
+		start = MBBitmapNextRange(MBRegUpdLost, from, REG_NUM, &num);
+
+		if (start >= REG_NUM)
+		{
+			/*Registers updated during this pass are left for next call*/
+			if (MBBitmapNextRange(MBRegUpdLost, 0, REG_NUM, &num) >= REG_NUM)
+			{
+				MBRegUpdOvf = 0;
+			}
+
+			MBRegUnlock();
+			break;
+		}
+
+		if (num > MODBUS_REGS_UPDQ_LEN)
+		{
+			num = MODBUS_REGS_UPDQ_LEN;
+		}
+
+		for (i = 0; i < num; i++)
+		{
+			vals[i] = MBRegVal[start + i];
+			MB_BITMAP_CLRBIT(MBRegUpdLost, start + i);
+		}
+
+		MBRegUnlock();
+
+		MBRegsUpdated(start, num, vals);
+		from = start + num;
+		cnt += num;
+	}
+
+	return cnt;
+}
+
+/**
+ * @brief Returns number of pending registers updates.
+ *        Queue is reported full until updates dropped on overflow are resynced.
+ */
+uint16_t MBRegUpdatesPending(void)
+{
+	if (MBRegUpdOvf)
+	{
+		return MODBUS_REGS_UPDQ_LEN;
+	}
+
+	return (uint16_t) (MBRegUpdQHead - MBRegUpdQTail);
+}
+#endif /*MODBUS_REGS_UPDQ_ENABLE*/
+
+#if MODBUS_NVM_ENABLE
+/**
+ * @brief Fetches non-volatile registers changed since last call
+ *        and clears their pending state. Used by storage journal.
+ * @param addr Pointer to registers addresses storage array
+ * @param val Pointer to registers values storage array
+ * @param max Size of storage arrays
+ * @return Number of fetched registers
+ */
+uint16_t MBRegNvFetch(uint16_t *addr, uint16_t *val, uint16_t max)
+{
+	uint16_t cnt = 0;
+	uint16_t from, num;
+
+	MBRegLock();
+
+	from = MBBitmapNextRange(MBRegNvPend, 0, REG_NUM, &num);
+
+	while ((from < REG_NUM) && (cnt < max))
+	{
+		for (; (num > 0) && (cnt < max); num--, from++, cnt++)
+		{
+			addr[cnt] = from;
+			val[cnt] = MBRegVal[from];
+			MB_BITMAP_CLRBIT(MBRegNvPend, from);
+		}
+
+		from = MBBitmapNextRange(MBRegNvPend, from, REG_NUM, &num);
+	}
+
+	MBRegUnlock();
+
+	return cnt;
+}
+
+/**
+ * @brief Marks non-volatile register as changed again. Used by storage journal
+ *        to retry failed write
+ * @param addr Register address
+ */
+void MBRegNvMarkPending(uint16_t addr)
+{
+	if ((addr >= REG_NUM) || !MB_BITMAP_BIT(MBRegNvMap, addr))
+	{
+		return;
+	}
+
+	MBRegLock();
+	MB_BITMAP_SETBIT(MBRegNvPend, addr);
+	MBRegUnlock();
+}
+
+/**
+ * @brief Checks if there are non-volatile registers waiting for storage flush
+ * @return Returns 1 if there are pending registers
+ */
+uint32_t MBRegNvIsPending(void)
+{
+	uint16_t num;
+
+	return MBBitmapNextRange(MBRegNvPend, 0, REG_NUM, &num) < REG_NUM;
+}
+
+/**
+ * @brief Restores non-volatile register value from storage journal
+ * @param addr Register address
+ * @param val Register value
+ * @return Error code
+ */
+MBerror MBRegNvRestore(uint16_t addr, uint16_t val)
+{
+	if ((addr >= REG_NUM) || !MB_BITMAP_BIT(MBRegNvMap, addr))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegVal[addr] = val;
+
+	return MODBUS_ERR_OK;
+}
+#endif /*MODBUS_NVM_ENABLE*/
+
+#if MODBUS_REGS_DIRTY_ENABLE
+/**
+ * @brief Copies changed registers bitmap and clears it
+ * @param map Pointer to bitmap storage (MB_BITMAP_WORDS(REG_NUM) words)
+ */
+void MBRegFetchChanges(uint32_t *map)
+{
+	MBRegLock();
+
+	memcpy(map, MBRegDirty, sizeof(MBRegDirty));
+	memset(MBRegDirty, 0, sizeof(MBRegDirty));
+
+	MBRegUnlock();
+}
+
+/**
+ * @brief Looks for next range of changed registers in fetched bitmap
+ * @param map Bitmap returned by MBRegFetchChanges()
+ * @param from Address to start search from
+ * @param num Pointer to range length storage variable
+ * @return Range start address or REG_NUM if there are no more changes
+ */
+uint16_t MBRegNextChange(const uint32_t *map, uint16_t from, uint16_t *num)
+{
+	return MBBitmapNextRange(map, from, REG_NUM, num);
+}
+
+/**
+ * @brief Subscribes callback to registers range changes.
+ *        Call on initialization before MBRegProcessChanges() usage.
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param cb Callback function
+ * @param arg Callback argument
+ * @return Error code
+ */
+MBerror MBRegSubscribe(uint16_t addr, uint16_t num, MBRegChangesCb_t cb, void *arg)
+{
+	uint32_t i;
+
+	if ((num == 0) || (addr >= REG_NUM) || (addr + num > REG_NUM) || (cb == NULL))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	for (i = 0; i < MODBUS_REGS_SUBSCR_NUM; i++)
+	{
+		if (MBRegSubscr[i].cb == NULL)
+		{
+			MBRegSubscr[i].addr = addr;
+			MBRegSubscr[i].num = num;
+			MBRegSubscr[i].arg = arg;
+			MBRegSubscr[i].cb = cb;
+
+			return MODBUS_ERR_OK;
+		}
+	}
+
+	return MODBUS_ERR_SYS;
+}
+
+/**
+ * @brief Fetches registers changes and calls subscribers for changed
+ *        parts of their ranges. Call from application task.
+ */
+void MBRegProcessChanges(void)
+{
+	uint32_t changes[MB_BITMAP_WORDS(REG_NUM)];
+	uint16_t addr, num;
+	uint32_t i;
+
+	MBRegFetchChanges(changes);
+
+	addr = MBRegNextChange(changes, 0, &num);
+
+	while (addr < REG_NUM)
+	{
+		for (i = 0; i < MODBUS_REGS_SUBSCR_NUM; i++)
+		{
+			RegSubscr_t *s = &MBRegSubscr[i];
+			uint16_t first = (s->addr > addr) ? s->addr : addr;
+			uint16_t end = (s->addr + s->num < addr + num) ? s->addr + s->num : addr + num;
+
+			if ((s->cb != NULL) && (first < end))
+			{
+				s->cb(first, end - first, s->arg);
+			}
+		}
+
+		addr = MBRegNextChange(changes, addr + num, &num);
+	}
+}
+#endif /*MODBUS_REGS_DIRTY_ENABLE*/
+
+/**
+ * @brief Checks registers range and its read permission
+ * @param addr Registers start address
+ * @param num Registers number
+ * @return Error code
+ */
+static MBerror MBRegCheckRead(uint16_t addr, uint16_t num)
+{
+	if ((addr < REG_NUM) && (addr + num <= REG_NUM))
+	{
+		/*Check read permission of the whole range*/
+		if (MBBitmapTest(MBRegRdMap, addr, num))
+		{
+			return MODBUS_ERR_OK;
+		}
+	}
+
+	return MODBUS_ERR_ILLEGADDR;
+}
+
+/**
+ * @brief Registers read. Registers lock must be taken
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to array will contain registers values
+ * @return Error code
+ */
+static MBerror MBRegRead(uint16_t addr, uint16_t num, uint16_t **pval)
+{
+	MBerror err;
+
+	MODBUS_TRACE("Read regs. Addr: %d, Num: %d\r\n", addr, num);
+
+	err = MBRegCheckRead(addr, num);
+
+	if (err == MODBUS_ERR_OK)
+	{
+#if REG_COMPUTED_NUM > 0
+		MBRegCompute(addr, num);
+#endif
+		*pval = &MBRegVal[addr];
+	}
+
+	return err;
+}
+
+/**
+ * @brief Registers write. Registers lock must be taken
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to array containing registers values
+ * @return Error code
+ */
+static MBerror MBRegWrite(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	MBerror err = MODBUS_ERR_OK;
+	uint32_t i;
+
+	MODBUS_TRACE("Preset regs. Addr: %d, Num: %d\r\n", addr, num);
+
+	if ((addr < REG_NUM) && (addr + num <= REG_NUM))
+	{
+#if MODBUS_REGS_ATOMIC_WR
+		/*Validate the whole range before any register is changed*/
+		err = MBRegCheckWrite(addr, num, pval);
+
+		if (err == MODBUS_ERR_OK)
+		{
+			for (i = 0; i < num; i++)
+			{
+				MBRegStore(addr + i, ARR2U16(&pval[2*i]));
+			}
+
+			MBRegNotify(addr, num);
+		}
+#else
+		/*Multi-register values are written completely or not written at all*/
+		err = MBRegCheckTyped(addr, num, pval);
+
+		if ((err == MODBUS_ERR_OK) &&
+			MBBitmapTest(MBRegWrMap, addr, num) && MBBitmapTest(MBRegNoLimMap, addr, num))
+		{
+			/*Whole range is writable and has no value restrictions*/
+			for (i = 0; i < num; i++)
+			{
+				MBRegStore(addr, ARR2U16(pval));
+				MBRegNotify(addr, 1);
+
+				addr++;
+				pval += 2;
+			}
+		}
+		else if (err == MODBUS_ERR_OK)
+		{
+			for (i = 0; i < num; i++)
+			{
+				uint16_t val = ARR2U16(pval);
+
+				/*Check permission & value*/
+				if (MB_BITMAP_BIT(MBRegWrMap, addr))
+				{
+					if (MB_BITMAP_BIT(MBRegNoLimMap, addr) || MBRegCheckVal(addr, val))
+					{
+						MBRegStore(addr, val);
+						MBRegNotify(addr, 1);
+					}
+					else
+					{
+						err = MODBUS_ERR_ILLEGVAL;
+					}
+				}
+				else
+				{
+					err = MODBUS_ERR_ILLEGADDR;
+				}
+
+				addr++;
+				pval += 2;
+			}
+		}
+#endif /*MODBUS_REGS_ATOMIC_WR*/
+	}
+	else
+	{
+		err = MODBUS_ERR_ILLEGADDR;
+	}
+
+	return err;
+}
+
+/**
+ * @brief Stores register value and marks it as changed
+ * @param addr Register address
+ * @param val Register value
+ */
+static void MBRegStore(uint16_t addr, uint16_t val)
+{
+	if (MBRegVal[addr] != val)
+	{
+#if MODBUS_REGS_DIRTY_ENABLE
+		MB_BITMAP_SETBIT(MBRegDirty, addr);
+#endif
+#if MODBUS_NVM_ENABLE
+		/*Same value writes don't reach storage*/
+		if (MB_BITMAP_BIT(MBRegNvMap, addr))
+		{
+			MB_BITMAP_SETBIT(MBRegNvPend, addr);
+		}
+#endif
+	}
+
+	MBRegVal[addr] = val;
+}
+
+/**
+ * @brief Notifies application about registers update.
+ *        Called with registers lock taken.
+ * @param addr Registers start address
+ * @param num Registers number
+ */
+static void MBRegNotify(uint16_t addr, uint16_t num)
+{
+#if MODBUS_REGS_UPDQ_ENABLE
+	uint32_t i;
+
+	for (i = 0; i < num; i++)
+	{
+		uint16_t head = MBRegUpdQHead;
+
+		if (!MBRegUpdOvf && ((uint16_t) (head - MBRegUpdQTail) < MODBUS_REGS_UPDQ_LEN))
+		{
+			MBRegUpdQ[head & (MODBUS_REGS_UPDQ_LEN - 1)].addr = addr + i;
+			MBRegUpdQ[head & (MODBUS_REGS_UPDQ_LEN - 1)].val = MBRegVal[addr + i];
+
+			/*Entry must be written before it becomes visible to consumer*/
+			MB_MEM_BARRIER();
+			MBRegUpdQHead = head + 1;
+		}
+		else
+		{
+			/*Queue is full. Update is resynced from register value by MBRegProcessUpdates()*/
+			MBRegUpdOvf = 1;
+			MB_BITMAP_SETBIT(MBRegUpdLost, addr + i);
+		}
+	}
+#else
+	MBRegsUpdated(addr, num, &MBRegVal[addr]);
+#endif
+}
+
+/**
+ * @brief Checks register value restrictions
+ * @param addr Register address
+ * @param val Value
+ * @return Returns 1 if permission available
+ */
+static uint32_t MBRegCheckVal(uint16_t addr, uint16_t val)
+{
+	return (val >= MBRegOpt[addr].min) & (val <= MBRegOpt[addr].max);
+}
+
+/**
+ * @brief Checks that typed values of the range are written completely
+ *        and their restrictions
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to array containing registers values
+ * @return Error code
+ */
+static MBerror MBRegCheckTyped(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+#if REG_TYPED_NUM > 0
+	const RegTyped_t *t;
+	uint32_t lo = 0;
+	uint32_t hi = REG_TYPED_NUM;
+	uint16_t n;
+
+	/*Most of requests don't touch typed values*/
+	if (MBBitmapNextRange(MBRegTypedMap, addr, addr + num, &n) >= addr + num)
+	{
+		return MODBUS_ERR_OK;
+	}
+
+	/*Look for first typed value ending after range start*/
+	while (lo < hi)
+	{
+		uint32_t mid = (lo + hi) / 2;
+
+		if (MBRegTyped[mid].addr + MBRegTyped[mid].size <= addr)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	for (t = &MBRegTyped[lo]; (t < &MBRegTyped[REG_TYPED_NUM]) && (t->addr < addr + num); t++)
+	{
+		uint8_t *data;
+		uint64_t raw = 0;
+		uint32_t ok = 1;
+		uint32_t raw32;
+		uint32_t i;
+		float f;
+
+		if ((t->addr < addr) || (t->addr + t->size > addr + num))
+		{
+			return MODBUS_ERR_ILLEGADDR;
+		}
+
+		/*Value is inside the range*/
+		data = &pval[2*(t->addr - addr)];
+
+		if (t->type == REG_TYPE_STR)
+		{
+			continue;
+		}
+
+		for (i = 0; i < t->size; i++)
+		{
+			uint32_t w = (t->order == REG_ORDER_MSW) ? i : t->size - 1 - i;
+
+			raw = (raw << 16) | ARR2U16(&data[2*w]);
+		}
+
+		switch (t->type)
+		{
+			case REG_TYPE_I16:
+				ok = ((int16_t) raw >= t->min.i) && ((int16_t) raw <= t->max.i);
+				break;
+
+			case REG_TYPE_I32:
+				ok = ((int32_t) raw >= t->min.i) && ((int32_t) raw <= t->max.i);
+				break;
+
+			case REG_TYPE_F32:
+				raw32 = (uint32_t) raw;
+				memcpy(&f, &raw32, sizeof(f));
+				/*NaN doesn't pass*/
+				ok = (f >= t->min.f) && (f <= t->max.f);
+				break;
+
+			default:
+				ok = (raw >= t->min.u) && (raw <= t->max.u);
+				break;
+		}
+
+		if (!ok)
+		{
+			return MODBUS_ERR_ILLEGVAL;
+		}
+	}
+#else
+	(void) addr;
+	(void) num;
+	(void) pval;
+#endif /*REG_TYPED_NUM*/
+
+	return MODBUS_ERR_OK;
+}
+
+#if REG_COMPUTED_NUM > 0
+/**
+ * @brief Calls read hooks of computed registers of the range.
+ *        Hooks are called with registers lock taken and must not use registers API.
+ * @param addr First register address
+ * @param num Registers number
+ */
+static void MBRegCompute(uint16_t addr, uint16_t num)
+{
+	const RegComputed_t *c;
+	uint32_t lo = 0;
+	uint32_t hi = REG_COMPUTED_NUM;
+	uint32_t now;
+	uint16_t n;
+
+	/*Most of requests don't touch computed registers*/
+	if (MBBitmapNextRange(MBRegComputedMap, addr, addr + num, &n) >= addr + num)
+	{
+		return;
+	}
+
+	/*Look for first computed register of the range*/
+	while (lo < hi)
+	{
+		uint32_t mid = (lo + hi) / 2;
+
+		if (MBRegComputed[mid].addr < addr)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	now = MODBUS_GET_TICK;
+
+	for (c = &MBRegComputed[lo]; (lo < REG_COMPUTED_NUM) && (c->addr < addr + num); c++, lo++)
+	{
+		if ((c->age > 0) && MB_BITMAP_BIT(MBRegComputedValid, lo) && ((uint32_t) (now - MBRegComputedTick[lo]) < c->age))
+		{
+			/*Memoized value is still fresh*/
+			continue;
+		}
+
+		MBRegVal[c->addr] = c->hook();
+		MBRegComputedTick[lo] = now;
+		MB_BITMAP_SETBIT(MBRegComputedValid, lo);
+	}
+}
+#endif /*REG_COMPUTED_NUM*/
+
+/**
+ * @brief Reads multi-register value
+ * @param addr First register address
+ * @param size Registers number (up to 4)
+ * @param order Words order
+ * @param err Pointer to error code storage variable
+ * @return Value
+ */
+static uint64_t MBRegGetWords(uint16_t addr, uint16_t size, uint8_t order, MBerror *err)
+{
+	uint64_t val = 0;
+	uint32_t i;
+
+	MBRegLock();
+
+	if ((addr < REG_NUM) && (addr + size <= REG_NUM))
+	{
+		*err = MODBUS_ERR_OK;
+
+		for (i = 0; i < size; i++)
+		{
+			val = (val << 16) | MBRegVal[(order == REG_ORDER_MSW) ? addr + i : addr + size - 1 - i];
+		}
+	}
+	else
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegUnlock();
+
+	return val;
+}
+
+/**
+ * @brief Writes multi-register value
+ * @param addr First register address
+ * @param size Registers number (up to 4)
+ * @param order Words order
+ * @param val Value
+ * @param err Pointer to error code storage variable
+ */
+static void MBRegSetWords(uint16_t addr, uint16_t size, uint8_t order, uint64_t val, MBerror *err)
+{
+	uint32_t i;
+
+	MBRegLock();
+
+	if ((addr < REG_NUM) && (addr + size <= REG_NUM))
+	{
+		*err = MODBUS_ERR_OK;
+
+		/*Least significant word first*/
+		for (i = 0; i < size; i++)
+		{
+			MBRegStore((order == REG_ORDER_MSW) ? addr + size - 1 - i : addr + i, (uint16_t) val);
+			val >>= 16;
+		}
+	}
+	else
+	{
+		*err = MODBUS_ERR_ILLEGADDR;
+	}
+
+	MBRegUnlock();
+}
+
+#if MODBUS_REGS_ATOMIC_WR
+/**
+ * @brief Checks write permission and value restrictions of the whole range
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to array containing registers values
+ * @return Error code
+ */
+static MBerror MBRegCheckWrite(uint16_t addr, uint16_t num, uint8_t *pval)
+{
+	uint32_t i;
+
+	if (!MBBitmapTest(MBRegWrMap, addr, num))
+	{
+		return MODBUS_ERR_ILLEGADDR;
+	}
+
+	if (!MBBitmapTest(MBRegNoLimMap, addr, num))
+	{
+		/*Check min/max of restricted registers only*/
+		for (i = 0; i < num; i++)
+		{
+			if (!MB_BITMAP_BIT(MBRegNoLimMap, addr + i) &&
+				!MBRegCheckVal(addr + i, ARR2U16(&pval[2*i])))
+			{
+				return MODBUS_ERR_ILLEGVAL;
+			}
+		}
+	}
+
+	return MBRegCheckTyped(addr, num, pval);
+}
+#endif /*MODBUS_REGS_ATOMIC_WR*/
+
+/**
+ * @brief Read hook of computed register: Reg 6
+ * @return Register value
+ */
+__weak uint16_t MBRegCompute_UPTIME(void)
+{
+	/* USER CODE BEGIN */
+	return REG_UPTIME_DEF;
+	/* USER CODE END */
+}
+
+/**
+ * @brief Register update callback
+ */
+__weak void MBRegUpdated(uint16_t addr, uint16_t val)
+{
+
+}
+
+/**
+ * @brief Registers range update callback. Called once per write request
+ *        with registers lock taken or from MBRegProcessUpdates() if
+ *        updates queue is enabled. By default calls MBRegUpdated()
+ *        for every register of the range.
+ * @param addr Registers start address
+ * @param num Registers number
+ * @param pval Pointer to new registers values
+ */
+__weak void MBRegsUpdated(uint16_t addr, uint16_t num, uint16_t *pval)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++)
+	{
+		MBRegUpdated(addr + i, pval[i]);
+	}
+}
+
+#if MODBUS_COILS_ENABLE
+/**
+ * @brief Coils range update callback. Called once per write request
+ *        with registers lock taken
+ * @param addr First coil address
+ * @param num Coils number
+ */
+__weak void MBCoilsUpdated(uint16_t addr, uint16_t num)
 {
 
 }
+#endif /*MODBUS_COILS_ENABLE*/
 
 /**
  * @brief Locks access to registers
@@ -20,6 +20,17 @@
 #define REG_OPT_SU_ONLY				(REG_OPT_SUR | REG_OPT_SUWR)
 #define REG_OPT_ALL					(REG_OPT_UR | REG_OPT_UWR | REG_OPT_SUR | REG_OPT_SUWR)
 
+#define REG_TYPE_U16				0
+#define REG_TYPE_I16				1
+#define REG_TYPE_U32				2
+#define REG_TYPE_I32				3
+#define REG_TYPE_F32				4
+#define REG_TYPE_U64				5
+#define REG_TYPE_STR				6
+
+#define REG_ORDER_MSW				0	/*Most significant word first*/
+#define REG_ORDER_LSW				1	/*Least significant word first*/
+
 /* Register: Reg 1
 * Addr: 0x0; Min: 0; Max: 100; Default: 0; Oper: R */
 #define REG_STATUS_ADDR				0x0
@@ -44,9 +55,62 @@
 #define REG_VALUE2_DEF      20
 #define REG_VALUE2_OPT      REG_OPT_ALL
 
+/* Register: Reg 4
+* Addr: 0x3; Type: F32; Order: MSW; Min: -10.0; Max: 100.0; Default: 20.5; Oper: RW */
+#define REG_SETPOINT_ADDR   0x3
+#define REG_SETPOINT_MIN    (-10.0f)
+#define REG_SETPOINT_MAX    (100.0f)
+#define REG_SETPOINT_DEF    (20.5f)
+#define REG_SETPOINT_OPT    REG_OPT_ALL
+#define REG_SETPOINT_TYPE   REG_TYPE_F32
+#define REG_SETPOINT_SIZE   2
+#define REG_SETPOINT_ORDER  REG_ORDER_MSW
+#define REG_SETPOINT_GET(err)       MBRegGetF32(REG_SETPOINT_ADDR, REG_SETPOINT_ORDER, err)
+#define REG_SETPOINT_SET(val, err)  MBRegSetF32(REG_SETPOINT_ADDR, REG_SETPOINT_ORDER, val, err)
+
+/* Register: Reg 6
+* Addr: 0x5; Min: 0; Max: 65535; Default: 0; Oper: R */
+#define REG_UPTIME_ADDR     0x5
+#define REG_UPTIME_MIN      0
+#define REG_UPTIME_MAX      65535
+#define REG_UPTIME_DEF      0
+#define REG_UPTIME_OPT      REG_OPT_R_ONLY
+#define REG_UPTIME_AGE      1000
+
+
+#define REG_LAST_ADDR	0x5 /*Last register address*/
+#define REG_NUM			6 /*Total registers number*/
+#define REG_TYPED_NUM	1 /*Typed values number*/
+#define REG_COMPUTED_NUM	1 /*Computed registers number*/
+
+/* Coil: Coil 1
+* Addr: 0x0; Default: 1; Oper: RW */
+#define COIL_PUMP_ADDR              0x0
+#define COIL_PUMP_DEF               1
+
+/* Coil: Coil 2
+* Addr: 0x1; Default: 0; Oper: RW */
+#define COIL_ALARM_RESET_ADDR       0x1
+#define COIL_ALARM_RESET_DEF        0
+
+/* Coil: Coil 3
+* Addr: 0x3; Default: 1; Oper: R */
+#define COIL_REMOTE_ADDR            0x3
+#define COIL_REMOTE_DEF             1
+
+#define COIL_NUM		4 /*Total coils number*/
+
+/* Input: Input 1
+* Addr: 0x0; Default: 0; Oper: R */
+#define DINP_DOOR_ADDR          0x0
+#define DINP_DOOR_DEF           0
 
-#define REG_LAST_ADDR	0x2 /*Last register address*/
-#define REG_NUM			3 /*Total registers number*/
+/* Input: Input 2
+* Addr: 0x1; Default: 0; Oper: R */
+#define DINP_LEVEL_HIGH_ADDR    0x1
+#define DINP_LEVEL_HIGH_DEF     0
+
+#define DINP_NUM		2 /*Total discrete inputs number*/
 
 /* USER CODE BEGIN */
 
@@ -55,10 +119,60 @@
 MBerror MBRegInit(void *arg);
 MBerror MBRegReadCallback(uint16_t addr, uint16_t num, uint16_t **pval);
 MBerror MBRegsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval);
+MBerror MBRegsReadWriteCallback(uint16_t rd_addr, uint16_t rd_num, uint8_t *rd_val,
+								uint16_t wr_addr, uint16_t wr_num, uint8_t *wr_val);
+MBerror MBRegMaskWriteCallback(uint16_t addr, uint16_t and_mask, uint16_t or_mask);
 void MBRegSetValue(uint16_t addr, uint16_t val, MBerror *err);
 uint16_t MBRegGetValue(uint16_t addr, MBerror *err);
 void MBRegUpdated(uint16_t addr, uint16_t val);
+void MBRegsUpdated(uint16_t addr, uint16_t num, uint16_t *pval);
 void MBRegLock(void);
 void MBRegUnlock(void);
 
+uint32_t MBRegGetU32(uint16_t addr, uint8_t order, MBerror *err);
+void MBRegSetU32(uint16_t addr, uint8_t order, uint32_t val, MBerror *err);
+uint64_t MBRegGetU64(uint16_t addr, uint8_t order, MBerror *err);
+void MBRegSetU64(uint16_t addr, uint8_t order, uint64_t val, MBerror *err);
+float MBRegGetF32(uint16_t addr, uint8_t order, MBerror *err);
+void MBRegSetF32(uint16_t addr, uint8_t order, float val, MBerror *err);
+void MBRegGetStr(uint16_t addr, uint16_t size, char *str, MBerror *err);
+void MBRegSetStr(uint16_t addr, uint16_t size, const char *str, MBerror *err);
+
+uint16_t MBRegCompute_UPTIME(void);
+
+#if MODBUS_COILS_ENABLE
+MBerror MBCoilsReadCallback(uint16_t addr, uint16_t num, uint8_t *pval);
+MBerror MBCoilsWriteCallback(uint16_t addr, uint16_t num, uint8_t *pval);
+uint8_t MBCoilGet(uint16_t addr, MBerror *err);
+void MBCoilSet(uint16_t addr, uint8_t val, MBerror *err);
+void MBCoilsUpdated(uint16_t addr, uint16_t num);
+#endif /*MODBUS_COILS_ENABLE*/
+
+#if MODBUS_DINP_ENABLE
+MBerror MBInputsReadCallback(uint16_t addr, uint16_t num, uint8_t *pval);
+uint8_t MBInputGet(uint16_t addr, MBerror *err);
+void MBInputSet(uint16_t addr, uint8_t val, MBerror *err);
+#endif /*MODBUS_DINP_ENABLE*/
+
+#if MODBUS_NVM_ENABLE
+uint16_t MBRegNvFetch(uint16_t *addr, uint16_t *val, uint16_t max);
+void MBRegNvMarkPending(uint16_t addr);
+uint32_t MBRegNvIsPending(void);
+MBerror MBRegNvRestore(uint16_t addr, uint16_t val);
+#endif /*MODBUS_NVM_ENABLE*/
+
+#if MODBUS_REGS_UPDQ_ENABLE
+uint16_t MBRegProcessUpdates(void);
+uint16_t MBRegUpdatesPending(void);
+#endif /*MODBUS_REGS_UPDQ_ENABLE*/
+
+#if MODBUS_REGS_DIRTY_ENABLE
+typedef void (*MBRegChangesCb_t)(uint16_t addr, uint16_t num, void *arg);
+
+void MBRegFetchChanges(uint32_t *map);
+uint16_t MBRegNextChange(const uint32_t *map, uint16_t from, uint16_t *num);
+MBerror MBRegSubscribe(uint16_t addr, uint16_t num, MBRegChangesCb_t cb, void *arg);
+void MBRegProcessChanges(void);
+#endif /*MODBUS_REGS_DIRTY_ENABLE*/
+
 #endif /*MB_REGS_H_*/
@@ -0,0 +1,191 @@
+/*
+ * mb_stats.c
+ *
+ * Server statistics counters and diagnostics function (FC8).
+ * Counters are updated by RTU and TCP servers, FC8 is served by RTU server
+ * for its own port (diagnostics is serial line function).
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_stats.h"
+#include <string.h>
+
+#if MODBUS_STATS_ENABLE
+
+/**
+ * @brief       Clears all counters of port
+ * @param st    Port statistics
+ */
+void MBStatsReset(MBStats_t *st)
+{
+	memset(st, 0, sizeof(*st));
+}
+
+/**
+ * @brief           Counts processed request
+ * @param st        Port statistics
+ * @param fcode     Function code
+ * @param err       Request result
+ * @param out_len   Response frame length, 0 if response isn't sent
+ * @param time      Time from request reception to response, ms
+ */
+void MBStatsRequest(MBStats_t *st, uint8_t fcode, MBerror err, uint32_t out_len, uint32_t time)
+{
+	uint32_t bucket = 0;
+
+	st->srv_msg++;
+	st->req[(fcode < MODBUS_STATS_FUNC_NUM) ? fcode : 0]++;
+
+	if (out_len == 0)
+	{
+		st->no_resp++;
+		return;
+	}
+
+	st->bytes_out += out_len;
+	st->time_sum += time;
+
+	if (time > st->time_max)
+	{
+		st->time_max = time;
+	}
+
+	if (err != MODBUS_ERR_OK)
+	{
+		st->exc[(err < MB_STATS_EXC_NUM) ? err : 0]++;
+	}
+
+	/*Bucket is bit length of time*/
+	while ((time != 0) && (bucket < MB_STATS_HIST_NUM - 1))
+	{
+		time >>= 1;
+		bucket++;
+	}
+
+	st->turnaround[bucket]++;
+}
+
+/**
+ * @brief       Returns number of exception responses of all codes
+ * @param st    Port statistics
+ * @return      Exception responses number
+ */
+uint32_t MBStatsExceptions(const MBStats_t *st)
+{
+	uint32_t sum = 0;
+	uint32_t i;
+
+	for (i = 0; i < MB_STATS_EXC_NUM; i++)
+	{
+		sum += st->exc[i];
+	}
+
+	return sum;
+}
+
+/**
+ * @brief               Function 08: diagnostics. Counters are returned as 16-bit values.
+ * @param st            Port statistics
+ * @param pReqData      Pointer to request message
+ * @param reqLen        Request message length
+ * @param pRespData     Pointer to response message
+ * @param respCap       Response buffer size
+ * @param pRespLen      Pointer to response length
+ * @return              Exception code
+ */
+MBerror MBStatsDiag(MBStats_t *st, uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap,
+					uint16_t *pRespLen)
+{
+	MBerror err = MODBUS_ERR_OK;
+	uint16_t sub = ARR2U16(&pReqData[1]);
+	uint32_t val = 0;
+
+	MB_ASSERT(respCap >= 5);
+
+	*pRespLen = 0;
+
+	/*Sub-function and data field*/
+	if ((reqLen < 5) || ((sub != MB_DIAG_RETURN_QUERY) && (reqLen != 5)) || (reqLen > respCap))
+	{
+		err = MODBUS_ERR_ILLEGVAL;
+	}
+	else
+	{
+		switch (sub)
+		{
+			case MB_DIAG_RETURN_QUERY:
+				/*Echo of request*/
+				break;
+
+			case MB_DIAG_RESTART:
+			case MB_DIAG_CLEAR:
+				if (((ARR2U16(&pReqData[3])) != 0x0000) && ((ARR2U16(&pReqData[3])) != 0xFF00))
+				{
+					err = MODBUS_ERR_ILLEGVAL;
+				}
+				else
+				{
+					MBStatsReset(st);
+				}
+				break;
+
+			case MB_DIAG_RETURN_REG:
+			case MB_DIAG_SRV_NAK:
+			case MB_DIAG_SRV_BUSY:
+				/*Not used by server*/
+				val = 0;
+				break;
+
+			case MB_DIAG_BUS_MSG:
+				val = st->bus_msg;
+				break;
+
+			case MB_DIAG_BUS_ERR:
+				val = st->crc_err;
+				break;
+
+			case MB_DIAG_BUS_EXC:
+				val = MBStatsExceptions(st);
+				break;
+
+			case MB_DIAG_SRV_MSG:
+				val = st->srv_msg;
+				break;
+
+			case MB_DIAG_SRV_NO_RESP:
+				val = st->no_resp;
+				break;
+
+			case MB_DIAG_OVERRUN:
+				val = st->overrun;
+				break;
+
+			default:
+				/*Sub-function isn't supported*/
+				err = MODBUS_ERR_ILLEGFUNC;
+				break;
+		}
+	}
+
+	if (err == MODBUS_ERR_OK)
+	{
+		memmove(pRespData, pReqData, reqLen);
+		*pRespLen = reqLen;
+
+		if ((sub != MB_DIAG_RETURN_QUERY) && (sub != MB_DIAG_RESTART) && (sub != MB_DIAG_CLEAR))
+		{
+			U162ARR((uint16_t) val, &pRespData[3]);
+		}
+	}
+	else
+	{
+		pRespData[0] = pReqData[0] | 0x80;
+		pRespData[1] = err;
+		*pRespLen = 2;
+	}
+
+	return err;
+}
+
+#endif /*MODBUS_STATS_ENABLE*/
@@ -0,0 +1,60 @@
+/*
+ * mb_stats.h
+ *
+ * Server statistics counters and diagnostics function (FC8)
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_STATS_H_
+#define MB_STATS_H_
+
+#include "mb_pdu.h"
+#include <stdint.h>
+
+#define MB_STATS_EXC_NUM		5	/*Exception counters: codes 1 - 4, [0] - other codes*/
+#define MB_STATS_HIST_NUM		8	/*Turnaround histogram buckets*/
+
+/**
+ * @brief FC8 diagnostics sub-functions
+ */
+#define MB_DIAG_RETURN_QUERY	0x00	/*Return query data*/
+#define MB_DIAG_RESTART			0x01	/*Restart communications option*/
+#define MB_DIAG_RETURN_REG		0x02	/*Return diagnostic register*/
+#define MB_DIAG_CLEAR			0x0A	/*Clear counters and diagnostic register*/
+#define MB_DIAG_BUS_MSG			0x0B	/*Return bus message count*/
+#define MB_DIAG_BUS_ERR			0x0C	/*Return bus communication error count*/
+#define MB_DIAG_BUS_EXC			0x0D	/*Return bus exception error count*/
+#define MB_DIAG_SRV_MSG			0x0E	/*Return server message count*/
+#define MB_DIAG_SRV_NO_RESP		0x0F	/*Return server no response count*/
+#define MB_DIAG_SRV_NAK			0x10	/*Return server NAK count*/
+#define MB_DIAG_SRV_BUSY		0x11	/*Return server busy count*/
+#define MB_DIAG_OVERRUN			0x12	/*Return bus character overrun count*/
+
+/**
+ * @brief Port statistics. Counters are written only from the port context
+ *        and may be read from any context without locks (32-bit reads are atomic).
+ */
+typedef struct {
+	uint32_t bus_msg;							/*!< Frames received from bus */
+	uint32_t crc_err;							/*!< Frames with CRC error */
+	uint32_t overrun;							/*!< Rx buffer overruns and interface errors */
+	uint32_t srv_msg;							/*!< Requests addressed to server */
+	uint32_t no_resp;							/*!< Requests without response */
+	uint32_t bytes_in;							/*!< Received bytes */
+	uint32_t bytes_out;							/*!< Sent bytes */
+	uint32_t time_sum;							/*!< Sum of response times, ms */
+	uint32_t time_max;							/*!< Maximum response time, ms */
+	uint32_t exc[MB_STATS_EXC_NUM];				/*!< Exception responses by code */
+	uint32_t req[MODBUS_STATS_FUNC_NUM];		/*!< Requests by function code, [0] - higher codes */
+	uint32_t turnaround[MB_STATS_HIST_NUM];		/*!< Response time histogram: bucket 0 - 0 ms, n - 2^(n-1)...2^n-1 ms,
+													 last bucket - all longer times */
+} MBStats_t;
+
+void MBStatsReset(MBStats_t *st);
+void MBStatsRequest(MBStats_t *st, uint8_t fcode, MBerror err, uint32_t out_len, uint32_t time);
+uint32_t MBStatsExceptions(const MBStats_t *st);
+MBerror MBStatsDiag(MBStats_t *st, uint8_t *pReqData, uint16_t reqLen, uint8_t *pRespData, uint16_t respCap,
+					uint16_t *pRespLen);
+
+#endif /* MB_STATS_H_ */
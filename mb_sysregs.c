@@ -0,0 +1,228 @@
+/*
+ * mb_sysregs.c
+ *
+ * System registers block. Rates are measured by MBSysRegsPoll() over
+ * MB_SYSREGS_WINDOW and summed over all monitored ports, read hooks
+ * return the last measured values.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_sysregs.h"
+#include "mb_regs.h"
+#include <stddef.h>
+
+/**
+ * @brief Port counters sum at window start
+ */
+typedef struct {
+	uint32_t bus_msg;
+	uint32_t crc_err;
+	uint32_t srv_msg;
+	uint32_t resp;
+	uint32_t time_sum;
+	uint32_t time_max;
+} MBSysCnt_t;
+
+static MBStats_t *sys_ports[MB_SYSREGS_PORTS_MAX];
+static uint8_t sys_ports_num;
+static MBSysCnt_t sys_last;
+static uint32_t sys_tick;
+static uint32_t sys_ms;				/*Uptime remainder, ms*/
+static volatile uint32_t sys_uptime;	/*Uptime, s*/
+static volatile uint16_t sys_req_rate;
+static volatile uint16_t sys_time_avg;
+static volatile uint16_t sys_crc_rate;
+
+/**
+ * @brief           Starts monitoring of ports. Without MODBUS_STATS_ENABLE pass no ports:
+ *                  uptime and updates queue depth are still measured, rates read 0
+ * @param ports     Statistics of ports (RTU and TCP servers handles)
+ * @param ports_num Ports number
+ * @return          Error code
+ */
+MBerror MBSysRegsInit(MBStats_t *const *ports, uint8_t ports_num)
+{
+	uint8_t i;
+
+	if ((ports_num > MB_SYSREGS_PORTS_MAX) || ((ports == NULL) && (ports_num != 0)))
+	{
+		return MODBUS_ERR_SYS;
+	}
+
+	for (i = 0; i < ports_num; i++)
+	{
+		sys_ports[i] = ports[i];
+	}
+
+	sys_ports_num = ports_num;
+	sys_tick = MODBUS_GET_TICK;
+	sys_ms = 0;
+	sys_uptime = 0;
+	sys_req_rate = 0;
+	sys_time_avg = 0;
+	sys_crc_rate = 0;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Sums counters of all ports
+ * @param cnt   Counters sum
+ */
+static void MBSysRegsSum(MBSysCnt_t *cnt)
+{
+	uint8_t i;
+
+	cnt->bus_msg = 0;
+	cnt->crc_err = 0;
+	cnt->srv_msg = 0;
+	cnt->resp = 0;
+	cnt->time_sum = 0;
+	cnt->time_max = 0;
+
+	for (i = 0; i < sys_ports_num; i++)
+	{
+		const MBStats_t *st = sys_ports[i];
+
+		cnt->bus_msg += st->bus_msg;
+		cnt->crc_err += st->crc_err;
+		cnt->srv_msg += st->srv_msg;
+		cnt->resp += st->srv_msg - st->no_resp;
+		cnt->time_sum += st->time_sum;
+
+		if (st->time_max > cnt->time_max)
+		{
+			cnt->time_max = st->time_max;
+		}
+	}
+}
+
+/**
+ * @brief       Counter increment over window. Counters cleared by FC8 start from 0
+ * @param cur   Current value
+ * @param last  Value at window start
+ * @return      Increment
+ */
+static uint32_t MBSysRegsDelta(uint32_t cur, uint32_t last)
+{
+	return (cur >= last) ? (cur - last) : cur;
+}
+
+/**
+ * @brief       Saturates value to register range
+ * @param val   Value
+ * @return      Register value
+ */
+static uint16_t MBSysRegsSat(uint32_t val)
+{
+	return (val > 0xFFFF) ? 0xFFFF : (uint16_t) val;
+}
+
+/**
+ * @brief Measures rates. Call periodically from application context
+ */
+void MBSysRegsPoll(void)
+{
+	MBSysCnt_t cnt;
+	uint32_t dt = MODBUS_GET_TICK - sys_tick;
+	uint32_t resp;
+	uint32_t bus;
+
+	if (dt < MB_SYSREGS_WINDOW)
+	{
+		return;
+	}
+
+	sys_tick += dt;
+	sys_ms += dt;
+	sys_uptime += sys_ms / 1000;
+	sys_ms %= 1000;
+
+	MBSysRegsSum(&cnt);
+
+	sys_req_rate = MBSysRegsSat((uint32_t) ((uint64_t) MBSysRegsDelta(cnt.srv_msg, sys_last.srv_msg) * 1000 / dt));
+
+	resp = MBSysRegsDelta(cnt.resp, sys_last.resp);
+	sys_time_avg = resp ? MBSysRegsSat(MBSysRegsDelta(cnt.time_sum, sys_last.time_sum) / resp) : 0;
+
+	bus = MBSysRegsDelta(cnt.bus_msg, sys_last.bus_msg);
+	sys_crc_rate = bus ? MBSysRegsSat((uint32_t) ((uint64_t) MBSysRegsDelta(cnt.crc_err, sys_last.crc_err) * 1000 / bus)) : 0;
+
+	sys_last = cnt;
+}
+
+#ifdef REG_SYS_UPTIME_H_ADDR
+
+/**
+ * @brief Read hook of computed register: uptime, s (high word)
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_UPTIME_H(void)
+{
+	return (uint16_t) (sys_uptime >> 16);
+}
+
+/**
+ * @brief Read hook of computed register: uptime, s (low word)
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_UPTIME_L(void)
+{
+	return (uint16_t) sys_uptime;
+}
+
+/**
+ * @brief Read hook of computed register: requests per second
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_REQ_RATE(void)
+{
+	return sys_req_rate;
+}
+
+/**
+ * @brief Read hook of computed register: average response time, ms
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_TIME_AVG(void)
+{
+	return sys_time_avg;
+}
+
+/**
+ * @brief Read hook of computed register: maximum response time since counters clear, ms
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_TIME_MAX(void)
+{
+	MBSysCnt_t cnt;
+
+	MBSysRegsSum(&cnt);
+
+	return MBSysRegsSat(cnt.time_max);
+}
+
+/**
+ * @brief Read hook of computed register: CRC errors per 1000 frames
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_CRC_RATE(void)
+{
+	return sys_crc_rate;
+}
+
+/**
+ * @brief Read hook of computed register: registers updates queue depth
+ * @return Register value
+ */
+uint16_t MBRegCompute_SYS_UPDQ_LEN(void)
+{
+#if MODBUS_REGS_UPDQ_ENABLE
+	return MBRegUpdatesPending();
+#else
+	return 0;
+#endif
+}
+
+#endif /*REG_SYS_UPTIME_H_ADDR*/
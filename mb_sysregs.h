@@ -0,0 +1,22 @@
+/*
+ * mb_sysregs.h
+ *
+ * System registers block: protocol performance metrics of the device
+ * in the register map. The block is added to the map by RegGen --sys option,
+ * its read hooks are implemented here.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_SYSREGS_H_
+#define MB_SYSREGS_H_
+
+#include "mb_stats.h"
+
+#define MB_SYSREGS_WINDOW		1000	/*Rates measurement window, ms*/
+#define MB_SYSREGS_PORTS_MAX	4		/*Maximum number of monitored ports*/
+
+MBerror MBSysRegsInit(MBStats_t *const *ports, uint8_t ports_num);
+void MBSysRegsPoll(void);
+
+#endif /* MB_SYSREGS_H_ */
@@ -0,0 +1,126 @@
+/*
+ * mb_trace.c
+ *
+ * Binary events trace. Unlike MODBUS_TRACE text output, writing a record
+ * takes a few stores, so the trace may be left enabled in the field and
+ * read for post-mortem analysis of latency spikes.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mb_trace.h"
+#include <stddef.h>
+#include <string.h>
+
+#if MODBUS_BTRACE_ENABLE
+
+/**
+ * @brief       Clears trace buffer
+ * @param tr    Trace buffer
+ * @param port  Port ID written to records
+ */
+void MBTraceInit(MBTrace_t *tr, uint8_t port)
+{
+	MB_ASSERT(tr != NULL);
+
+	memset(tr, 0, sizeof(*tr));
+	tr->port = port;
+}
+
+/**
+ * @brief       Writes trace record. Must be called from the port context only
+ * @param tr    Trace buffer, NULL if trace is disabled for the port
+ * @param event Event MB_TRACE_EV_x
+ * @param func  Function code
+ * @param addr  Address
+ * @param num   Count
+ * @param err   Error code
+ */
+void MBTraceEvent(MBTrace_t *tr, uint8_t event, uint8_t func, uint16_t addr, uint16_t num, uint8_t err)
+{
+	if (tr == NULL)
+	{
+		return;
+	}
+
+	uint32_t head = tr->head;
+	volatile MBTraceRec_t *rec = &tr->rec[head & (MODBUS_BTRACE_LEN - 1)];
+
+	rec->time = MODBUS_BTRACE_TIME;
+	rec->addr = addr;
+	rec->num = num;
+	rec->port = tr->port;
+	rec->event = event;
+	rec->func = func;
+	rec->err = err;
+
+	/*Record must be written before it becomes visible to reader*/
+	MB_MEM_BARRIER();
+	tr->head = head + 1;
+}
+
+/**
+ * @brief       Writes request record with address and count fields of PDU
+ * @param tr    Trace buffer, NULL if trace is disabled for the port
+ * @param pdu   Request PDU
+ * @param len   PDU length
+ */
+void MBTraceRequest(MBTrace_t *tr, const uint8_t *pdu, uint16_t len)
+{
+	uint16_t addr = (len >= 3) ? (ARR2U16(&pdu[1])) : 0;
+	uint16_t num = (len >= 5) ? (ARR2U16(&pdu[3])) : 0;
+
+	MBTraceEvent(tr, MB_TRACE_EV_REQ, (len >= 1) ? pdu[0] : 0, addr, num, 0);
+}
+
+/**
+ * @brief       Copies records oldest first. Slot of the next record isn't copied,
+ *              records overwritten during copy are skipped.
+ * @param tr    Trace buffer
+ * @param recs  Records storage
+ * @param max   Records storage size
+ * @return      Copied records number
+ */
+uint32_t MBTraceRead(const MBTrace_t *tr, MBTraceRec_t *recs, uint32_t max)
+{
+	uint32_t head = tr->head;
+	uint32_t num = (head < MODBUS_BTRACE_LEN - 1) ? head : MODBUS_BTRACE_LEN - 1;
+	uint32_t first;
+	uint32_t lost;
+	uint32_t i;
+
+	if (num > max)
+	{
+		num = max;
+	}
+
+	first = head - num;
+
+	MB_MEM_BARRIER();
+
+	for (i = 0; i < num; i++)
+	{
+		recs[i] = tr->rec[(first + i) & (MODBUS_BTRACE_LEN - 1)];
+	}
+
+	MB_MEM_BARRIER();
+
+	/*Writer may overwrite oldest records during copy, next record may be in progress*/
+	lost = tr->head + 1 - MODBUS_BTRACE_LEN - first;
+
+	if ((int32_t) lost <= 0)
+	{
+		return num;
+	}
+
+	if (lost >= num)
+	{
+		return 0;
+	}
+
+	memmove(recs, &recs[lost], (num - lost) * sizeof(MBTraceRec_t));
+
+	return num - lost;
+}
+
+#endif /*MODBUS_BTRACE_ENABLE*/
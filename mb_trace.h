@@ -0,0 +1,58 @@
+/*
+ * mb_trace.h
+ *
+ * Binary events trace. Fixed size records are written to per-port ring buffers
+ * without locks and decoded on host by Scripts/mb_trace_decode.py.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MB_TRACE_H_
+#define MB_TRACE_H_
+
+#include "mb_pdu.h"
+#include <stdint.h>
+
+/**
+ * @brief Trace events. Record fields use:
+ *        REQ  - function code, address and count fields of request
+ *        RESP - function code, response PDU length in count (0 - no response), exception code
+ *        CRC  - function code, frame length in count
+ *        DROP - incorrect TCP frame: MBAP length in count
+ *        CONN - new TCP connection
+ */
+#define MB_TRACE_EV_REQ			1	/*Request is received*/
+#define MB_TRACE_EV_RESP		2	/*Request is processed*/
+#define MB_TRACE_EV_CRC			3	/*Addressed frame with CRC error*/
+#define MB_TRACE_EV_DROP		4	/*Incorrect frame is dropped*/
+#define MB_TRACE_EV_CONN		5	/*Connection is accepted*/
+
+/**
+ * @brief Trace record, 12 bytes without padding
+ */
+typedef struct {
+	uint32_t time;					/*!< MODBUS_BTRACE_TIME timestamp */
+	uint16_t addr;					/*!< Address */
+	uint16_t num;					/*!< Count */
+	uint8_t port;					/*!< Port ID */
+	uint8_t event;					/*!< Event MB_TRACE_EV_x */
+	uint8_t func;					/*!< Function code */
+	uint8_t err;					/*!< Error/exception code */
+} MBTraceRec_t;
+
+/**
+ * @brief Port trace ring buffer. The only writer is the port context,
+ *        oldest records are overwritten.
+ */
+typedef struct {
+	volatile uint32_t head;						/*!< Records written, free running */
+	uint8_t port;								/*!< Port ID of records */
+	MBTraceRec_t rec[MODBUS_BTRACE_LEN];		/*!< Records ring */
+} MBTrace_t;
+
+void MBTraceInit(MBTrace_t *tr, uint8_t port);
+void MBTraceEvent(MBTrace_t *tr, uint8_t event, uint8_t func, uint16_t addr, uint16_t num, uint8_t err);
+void MBTraceRequest(MBTrace_t *tr, const uint8_t *pdu, uint16_t len);
+uint32_t MBTraceRead(const MBTrace_t *tr, MBTraceRec_t *recs, uint32_t max);
+
+#endif /* MB_TRACE_H_ */
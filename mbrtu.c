@@ -44,6 +44,9 @@ MBerror MBRTU_Init(MBRTU_Handle_t *mb)
 
 	mb->rx_byte = mb->rx_buf;
 	mb->mbmode = RX;
+#if MODBUS_STATS_ENABLE
+	MBStatsReset(&mb->stats);
+#endif
 
 	MODBUS_TRACE("Starting Modbus RTU with Address %d\r\n", mb->addr);
 
@@ -81,6 +84,10 @@ void MBRTU_Poll(MBRTU_Handle_t *mb)
 			/*Check message minimal length*/
 			if (rx_len > MODBUS_MSG_MIN_LEN)
 			{
+#if MODBUS_STATS_ENABLE
+				mb->stats.bus_msg++;
+				mb->stats.bytes_in += rx_len;
+#endif
 				/*Parse incoming message*/
 				MBRTU_Parser(mb, rx_len);
 			}
@@ -117,8 +124,30 @@ static void MBRTU_Parser(MBRTU_Handle_t *mb, uint16_t len)
 		/*Check CRC with incoming data*/
 		if (tmp_crc == MBRTU_CRC(mb->rx_buf, len - 2))
 		{
+#if MODBUS_BTRACE_ENABLE
+			MBTraceRequest(mb->trace, pPDU, len - 3);
+#endif
+
 		    /* Parse PDU data */
-			err = MB_PDU_Parser(pPDU, pResp, &resp_len);
+#if MODBUS_STATS_ENABLE
+			if (pPDU[0] == MODBUS_FUNC_DIAG)
+			{
+				/*Diagnostics counters belong to serial port*/
+				err = MBStatsDiag(&mb->stats, pPDU, len - 3, pResp, MBRTU_MAX_MSG_LEN - 3, &resp_len);
+			}
+			else
+#endif
+			{
+				err = MB_PDU_Parser(pPDU, len - 3, pResp, MBRTU_MAX_MSG_LEN - 3, &resp_len);
+			}
+
+#if MODBUS_STATS_ENABLE
+			MBStatsRequest(&mb->stats, pPDU[0], err, resp_len ? 1 + resp_len + 2 : 0,
+						   MODBUS_GET_TICK - mb->last_rx_byte_time);
+#endif
+#if MODBUS_BTRACE_ENABLE
+			MBTraceEvent(mb->trace, MB_TRACE_EV_RESP, pPDU[0], 0, resp_len, err);
+#endif
 
 			if (resp_len > 0)
 			{
@@ -138,6 +167,12 @@ static void MBRTU_Parser(MBRTU_Handle_t *mb, uint16_t len)
 		else
 		{
 			MODBUS_TRACE("Incorrect CRC\r\n");
+#if MODBUS_STATS_ENABLE
+			mb->stats.crc_err++;
+#endif
+#if MODBUS_BTRACE_ENABLE
+			MBTraceEvent(mb->trace, MB_TRACE_EV_CRC, pPDU[0], 0, len, 0);
+#endif
 		}
 	}
 }
@@ -180,6 +215,9 @@ void MBRTU_ByteReceivedCallback(MBRTU_Handle_t *mb)
 		{
 			/* not normal case*/
 			mb->rx_byte = mb->rx_buf;
+#if MODBUS_STATS_ENABLE
+			mb->stats.overrun++;
+#endif
 		}
 
 		/*Receive next byte*/
@@ -211,6 +249,9 @@ void MBRTU_error(MBRTU_Handle_t *mb)
 	MB_ASSERT(mb != NULL);
 
 	mb->rx_stop();
+#if MODBUS_STATS_ENABLE
+	mb->stats.overrun++;
+#endif
 
 	mb->rx_byte = mb->rx_buf;
 	mb->mbmode = RX;
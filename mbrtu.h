@@ -9,6 +9,12 @@
 #define MBRTU_H_
 
 #include "mb_pdu.h"
+#if MODBUS_STATS_ENABLE
+#include "mb_stats.h"
+#endif
+#if MODBUS_BTRACE_ENABLE
+#include "mb_trace.h"
+#endif
 
 /**
  * @brief Defines maximum message size as maximum application data unit (ADU)
@@ -27,7 +33,7 @@ typedef enum {DELOW = 0, DEHIGH} de_state_t;
 typedef struct {
 	uint8_t addr;										/*!< Slave address */
 	uint8_t *rx_buf;									/*!< Pointer to Rx buffer */
-	uint8_t *tx_buf;									/*!< Pointer to Tx buffer */
+	uint8_t *tx_buf;									/*!< Pointer to Tx buffer (MBRTU_MAX_MSG_LEN bytes) */
 	uint8_t *rx_byte;									/*!< Pointer to current rx byte */
 	uint32_t rx_buf_len;								/*!< Size of rx buffer */
 	uint32_t last_rx_byte_time;							/*!< Time of reception last byte */
@@ -39,6 +45,12 @@ typedef struct {
 #if MODBUS_USE_US_TIMER
 	void (*us_sleep)(uint16_t us);						/*!< us timer function pointer */
 #endif
+#if MODBUS_STATS_ENABLE
+	MBStats_t stats;									/*!< Port statistics */
+#endif
+#if MODBUS_BTRACE_ENABLE
+	MBTrace_t *trace;									/*!< Port trace buffer (NULL - disabled) */
+#endif
 } MBRTU_Handle_t;
 
 MBerror MBRTU_Init(MBRTU_Handle_t *mb);
@@ -71,6 +71,10 @@ MBerror MBTCP_Init(MBTCP_Handle_t *mbtcp)
 
     MODBUS_TRACE("TCP Modbus Initialization\r\n");
 
+#if MODBUS_STATS_ENABLE
+    MBStatsReset(&mbtcp->stats);
+#endif
+
 #if MODBUS_REGS_ENABLE
 	if (MBRegInit(NULL) != MODBUS_ERR_OK)
 	{
@@ -159,6 +163,9 @@ static void MBTCP_Thread(void *arg)
         inet_ntop(AF_INET, &(client_addr.sin_addr), str, INET_ADDRSTRLEN);
         MODBUS_TRACE("New connection from %s\r\n", str);
 #endif /* MODBUS_TRACE_ENABLE */
+#if MODBUS_BTRACE_ENABLE
+        MBTraceEvent(mbtcp->trace, MB_TRACE_EV_CONN, 0, 0, 0, 0);
+#endif
 
         while (1)
         {
@@ -224,6 +231,13 @@ static uint32_t MBTCP_PacketParser(MBTCP_Handle_t *mbtcp, uint32_t inlen)
     MBerror err;
     uint16_t resp_len = 0;
 
+#if MODBUS_STATS_ENABLE
+    uint32_t start_tick = MODBUS_GET_TICK;
+
+    mbtcp->stats.bus_msg++;
+    mbtcp->stats.bytes_in += inlen;
+#endif
+
     /*MBAP + function code + start addr + points num*/
     if (inlen < MBAP_SIZE + 1 + 4)
     {
@@ -240,12 +254,28 @@ static uint32_t MBTCP_PacketParser(MBTCP_Handle_t *mbtcp, uint32_t inlen)
     if (mbap.prot_id != 0)
     {
         MODBUS_TRACE("Incorrect Protocol ID: %d\r\n", mbap.prot_id);
+#if MODBUS_BTRACE_ENABLE
+        MBTraceEvent(mbtcp->trace, MB_TRACE_EV_DROP, 0, 0, mbap.plen, 0);
+#endif
+        return 0;
+    }
+
+    /*Length field counts unit ID and PDU*/
+    if ((mbap.plen < 2) || (MBAP_SIZE - 1 + mbap.plen > inlen))
+    {
+        MODBUS_TRACE("Incorrect length: %d\r\n", mbap.plen);
+#if MODBUS_BTRACE_ENABLE
+        MBTraceEvent(mbtcp->trace, MB_TRACE_EV_DROP, 0, 0, mbap.plen, 0);
+#endif
         return 0;
     }
 
     if ((mbap.unit_id != mbtcp->unit) || (mbap.unit_id > 247))
     {
         MODBUS_TRACE("Incorrect unit ID: %d\r\n", mbap.unit_id);
+#if MODBUS_BTRACE_ENABLE
+        MBTraceEvent(mbtcp->trace, MB_TRACE_EV_DROP, 0, 0, mbap.plen, 0);
+#endif
         return 0;
     }
 
@@ -253,7 +283,11 @@ static uint32_t MBTCP_PacketParser(MBTCP_Handle_t *mbtcp, uint32_t inlen)
     uint8_t *pPDU = &indata[MBAP_SIZE];
     uint8_t *pResp = &mbtcp->tx_buf[MBAP_SIZE];
 
-    err = MB_PDU_Parser(pPDU, pResp, &resp_len);
+#if MODBUS_BTRACE_ENABLE
+    MBTraceRequest(mbtcp->trace, pPDU, mbap.plen - 1);
+#endif
+
+    err = MB_PDU_Parser(pPDU, mbap.plen - 1, pResp, mbtcp->tx_buf_size - MBAP_SIZE, &resp_len);
 
     if (resp_len > 0)
     {
@@ -266,5 +300,12 @@ static uint32_t MBTCP_PacketParser(MBTCP_Handle_t *mbtcp, uint32_t inlen)
         outlen = MBTCP_Response(mbtcp, &mbap, resp_len);
     }
 
+#if MODBUS_STATS_ENABLE
+    MBStatsRequest(&mbtcp->stats, pPDU[0], err, outlen, MODBUS_GET_TICK - start_tick);
+#endif
+#if MODBUS_BTRACE_ENABLE
+    MBTraceEvent(mbtcp->trace, MB_TRACE_EV_RESP, pPDU[0], 0, resp_len, err);
+#endif
+
     return outlen;
 }
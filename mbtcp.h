@@ -9,6 +9,12 @@
 #define MBTCP_SERVER_H_
 
 #include "modbus_conf.h"
+#if MODBUS_STATS_ENABLE
+#include "mb_stats.h"
+#endif
+#if MODBUS_BTRACE_ENABLE
+#include "mb_trace.h"
+#endif
 
 /**
  * @brief Defines maximum packet size as maximum application data unit (ADU)
@@ -24,6 +30,12 @@ typedef struct {
         uint8_t *tx_buf;                                    /*!< Pointer to Tx buffer */
         uint16_t rx_buf_size;                               /*!< Rx buffer size */
         uint16_t tx_buf_size;                               /*!< Tx buffer size */
+#if MODBUS_STATS_ENABLE
+        MBStats_t stats;                                    /*!< Server statistics */
+#endif
+#if MODBUS_BTRACE_ENABLE
+        MBTrace_t *trace;                                   /*!< Server trace buffer (NULL - disabled) */
+#endif
 } MBTCP_Handle_t;
 
 MBerror MBTCP_Init(MBTCP_Handle_t *mbtcp);
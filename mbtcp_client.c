@@ -0,0 +1,283 @@
+/*
+ * mbtcp_client.c
+ *
+ * Pipelined Modbus TCP client. Up to window requests are sent without waiting
+ * for responses, responses are matched by MBAP transaction ID, so polling
+ * throughput doesn't depend on round-trip time. Transport independent:
+ * data received from connection is passed to MBTCPC_Receive() in any chunks.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "mbtcp_client.h"
+#include <string.h>
+
+#define MBAP_SIZE                   7                   /* MBAP header size */
+
+#define MBTCPC_FREE                 0
+#define MBTCPC_QUEUED               1
+#define MBTCPC_SENT                 2
+#define MBTCPC_DONE                 3
+
+static void MBTCPC_Send(MBTCPC_Handle_t *cl);
+static void MBTCPC_Response(MBTCPC_Handle_t *cl, const uint8_t *frame, uint16_t len);
+static void MBTCPC_Complete(MBTCPC_Handle_t *cl, MBTCPC_Slot_t *slot, MBerror err);
+
+/**
+ * @brief       ModBus TCP client initialization. itfs_write, window and timeout must be set
+ * @param cl    Client handle
+ * @return      Error code
+ */
+MBerror MBTCPC_Init(MBTCPC_Handle_t *cl)
+{
+    MB_ASSERT(cl != NULL);
+
+    if ((cl->itfs_write == NULL) || (cl->window == 0) || (cl->window > MODBUS_TCP_CLIENT_REQ_NUM))
+    {
+        return MODBUS_ERR_MASTER;
+    }
+
+    memset(cl->slots, 0, sizeof(cl->slots));
+    cl->tran_id = 0;
+    cl->sent = 0;
+    cl->order = 0;
+    cl->rx_len = 0;
+
+    return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Queues request and sends it if window isn't full. Request is copied, so it may be
+ *              located on stack. Must be called from the same context as MBTCPC_Receive() and MBTCPC_Poll().
+ * @param cl    Client handle
+ * @param req   Request. Slave address is used as unit ID.
+ * @return      Error code. MODBUS_ERR_BUSY if there is no free request slot.
+ */
+MBerror MBTCPC_Submit(MBTCPC_Handle_t *cl, const SiMasterReq_t *req)
+{
+    MBTCPC_Slot_t *slot = NULL;
+    MBerror err = SiMasterCheckReq(req);
+    uint32_t i;
+
+    if (err != MODBUS_ERR_OK)
+    {
+        return err;
+    }
+
+    for (i = 0; i < MODBUS_TCP_CLIENT_REQ_NUM; i++)
+    {
+        if (cl->slots[i].state == MBTCPC_FREE)
+        {
+            slot = &cl->slots[i];
+            break;
+        }
+    }
+
+    if (slot == NULL)
+    {
+        return MODBUS_ERR_BUSY;
+    }
+
+    slot->req = *req;
+    slot->req.next = NULL;
+    slot->order = cl->order++;
+    slot->state = MBTCPC_QUEUED;
+
+    MBTCPC_Send(cl);
+
+    return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Passes data received from connection. Complete responses are matched
+ *              with outstanding requests, partial response is kept until the rest arrives.
+ * @param cl    Client handle
+ * @param data  Received data
+ * @param len   Received data length
+ * @return      Error code. MODBUS_ERR_SYS if stream is corrupted: close connection and call MBTCPC_Reset().
+ */
+MBerror MBTCPC_Receive(MBTCPC_Handle_t *cl, const uint8_t *data, uint32_t len)
+{
+    uint32_t n;
+    uint16_t frame_len;
+
+    while (len > 0)
+    {
+        n = sizeof(cl->rx_buf) - cl->rx_len;
+        n = (len < n) ? len : n;
+
+        memcpy(&cl->rx_buf[cl->rx_len], data, n);
+        cl->rx_len += n;
+        data += n;
+        len -= n;
+
+        while (cl->rx_len >= MBAP_SIZE)
+        {
+            /*Length field counts unit ID and PDU*/
+            frame_len = (uint16_t) (MBAP_SIZE - 1 + (ARR2U16(&cl->rx_buf[4])));
+
+            if (((ARR2U16(&cl->rx_buf[2])) != 0) || (frame_len < MBAP_SIZE + 1) || (frame_len > sizeof(cl->rx_buf)))
+            {
+                MODBUS_TRACE("TCP client: incorrect MBAP\r\n");
+                cl->rx_len = 0;
+                return MODBUS_ERR_SYS;
+            }
+
+            if (cl->rx_len < frame_len)
+            {
+                break;
+            }
+
+            MBTCPC_Response(cl, cl->rx_buf, frame_len);
+
+            cl->rx_len -= frame_len;
+            memmove(cl->rx_buf, &cl->rx_buf[frame_len], cl->rx_len);
+        }
+    }
+
+    MBTCPC_Send(cl);
+
+    return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Completes timed out requests and sends queued ones. Call it periodically.
+ * @param cl    Client handle
+ */
+void MBTCPC_Poll(MBTCPC_Handle_t *cl)
+{
+    MBTCPC_Slot_t *slot;
+    uint32_t i;
+
+    for (i = 0; i < MODBUS_TCP_CLIENT_REQ_NUM; i++)
+    {
+        slot = &cl->slots[i];
+
+        if ((slot->state == MBTCPC_SENT) && ((uint32_t) (MODBUS_GET_TICK - slot->tick) >= cl->timeout))
+        {
+            MBTCPC_Complete(cl, slot, MODBUS_ERR_TIMEOUT);
+        }
+    }
+
+    MBTCPC_Send(cl);
+}
+
+/**
+ * @brief       Completes all requests with MODBUS_ERR_INTFS and drops received data.
+ *              Call it when connection is closed.
+ * @param cl    Client handle
+ */
+void MBTCPC_Reset(MBTCPC_Handle_t *cl)
+{
+    uint32_t i;
+
+    cl->rx_len = 0;
+
+    for (i = 0; i < MODBUS_TCP_CLIENT_REQ_NUM; i++)
+    {
+        if ((cl->slots[i].state == MBTCPC_QUEUED) || (cl->slots[i].state == MBTCPC_SENT))
+        {
+            MBTCPC_Complete(cl, &cl->slots[i], MODBUS_ERR_INTFS);
+        }
+    }
+}
+
+/**
+ * @brief       Sends queued requests in submission order while window isn't full
+ * @param cl    Client handle
+ */
+static void MBTCPC_Send(MBTCPC_Handle_t *cl)
+{
+    MBTCPC_Slot_t *slot;
+    uint8_t *tx = cl->tx_buf;
+    uint16_t len;
+    uint32_t i;
+
+    while (cl->sent < cl->window)
+    {
+        slot = NULL;
+
+        for (i = 0; i < MODBUS_TCP_CLIENT_REQ_NUM; i++)
+        {
+            if ((cl->slots[i].state == MBTCPC_QUEUED) &&
+                ((slot == NULL) || ((int32_t) (cl->slots[i].order - slot->order) < 0)))
+            {
+                slot = &cl->slots[i];
+            }
+        }
+
+        if (slot == NULL)
+        {
+            break;
+        }
+
+        len = SiMasterPDUBuild(&slot->req, &tx[MBAP_SIZE]);
+
+        slot->tran_id = ++cl->tran_id;
+        slot->tick = MODBUS_GET_TICK;
+        slot->state = MBTCPC_SENT;
+        cl->sent++;
+
+        U162ARR(slot->tran_id, tx);
+        U162ARR(0, &tx[2]);
+        U162ARR(len + 1, &tx[4]);
+        tx[6] = slot->req.slave;
+
+        if (cl->itfs_write(tx, MBAP_SIZE + len) != MODBUS_ERR_OK)
+        {
+            MBTCPC_Complete(cl, slot, MODBUS_ERR_INTFS);
+        }
+    }
+}
+
+/**
+ * @brief       Matches response with outstanding request and completes it.
+ *              Responses of timed out requests are dropped.
+ * @param cl    Client handle
+ * @param frame Response frame (MBAP and PDU)
+ * @param len   Frame length
+ */
+static void MBTCPC_Response(MBTCPC_Handle_t *cl, const uint8_t *frame, uint16_t len)
+{
+    uint16_t tran_id = ARR2U16(frame);
+    MBTCPC_Slot_t *slot;
+    uint32_t i;
+
+    for (i = 0; i < MODBUS_TCP_CLIENT_REQ_NUM; i++)
+    {
+        slot = &cl->slots[i];
+
+        if ((slot->state == MBTCPC_SENT) && (slot->tran_id == tran_id))
+        {
+            MBTCPC_Complete(cl, slot, (frame[6] == slot->req.slave) ?
+                            SiMasterPDUParse(&slot->req, &frame[MBAP_SIZE], len - MBAP_SIZE) : MODBUS_ERR_VALUE);
+            return;
+        }
+    }
+
+    MODBUS_TRACE("TCP client: unexpected transaction %d\r\n", tran_id);
+}
+
+/**
+ * @brief       Calls request callback and frees request slot
+ * @param cl    Client handle
+ * @param slot  Request slot
+ * @param err   Request result
+ */
+static void MBTCPC_Complete(MBTCPC_Handle_t *cl, MBTCPC_Slot_t *slot, MBerror err)
+{
+    if (slot->state == MBTCPC_SENT)
+    {
+        cl->sent--;
+    }
+
+    /*Slot isn't reused by requests submitted from callback*/
+    slot->state = MBTCPC_DONE;
+
+    if (slot->req.cb)
+    {
+        slot->req.cb(err, &slot->req);
+    }
+
+    slot->state = MBTCPC_FREE;
+}
@@ -0,0 +1,49 @@
+/*
+ * mbtcp_client.h
+ *
+ * Pipelined Modbus TCP client. Requests are built and parsed by the
+ * master PDU engine (simple_master.c).
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef MBTCP_CLIENT_H_
+#define MBTCP_CLIENT_H_
+
+#include "mbtcp.h"
+#include "simple_master.h"
+
+/**
+ * @brief Client request slot
+ */
+typedef struct {
+    SiMasterReq_t req;                                  /*!< Request */
+    uint16_t tran_id;                                   /*!< Transaction ID of sent request */
+    uint8_t state;                                      /*!< Slot state (free, queued, sent) */
+    uint32_t order;                                     /*!< Submission order of queued request */
+    uint32_t tick;                                      /*!< Send tick */
+} MBTCPC_Slot_t;
+
+/**
+ * @brief Modbus TCP client handle (one per connection)
+ */
+typedef struct {
+    MBerror (*itfs_write)(uint8_t *data, uint32_t len); /*!< Connection send function pointer */
+    uint8_t window;                                     /*!< Maximum number of outstanding requests */
+    uint32_t timeout;                                   /*!< Response timeout, ms */
+    uint16_t tran_id;                                   /*!< Last transaction ID */
+    uint8_t sent;                                       /*!< Outstanding requests number */
+    uint32_t order;                                     /*!< Next submission order */
+    uint16_t rx_len;                                    /*!< Reassembly buffer length */
+    MBTCPC_Slot_t slots[MODBUS_TCP_CLIENT_REQ_NUM];     /*!< Requests */
+    uint8_t rx_buf[MBTCP_MAX_PACKET_SIZE];              /*!< Reassembly buffer */
+    uint8_t tx_buf[MBTCP_MAX_PACKET_SIZE];              /*!< Tx buffer */
+} MBTCPC_Handle_t;
+
+MBerror MBTCPC_Init(MBTCPC_Handle_t *cl);
+MBerror MBTCPC_Submit(MBTCPC_Handle_t *cl, const SiMasterReq_t *req);
+MBerror MBTCPC_Receive(MBTCPC_Handle_t *cl, const uint8_t *data, uint32_t len);
+void MBTCPC_Poll(MBTCPC_Handle_t *cl);
+void MBTCPC_Reset(MBTCPC_Handle_t *cl);
+
+#endif /* MBTCP_CLIENT_H_ */
@@ -19,8 +19,35 @@
 #define MODBUS_REGS_ENABLE		1	/*Enable registers. Function 3, 4*/
 #define MODBUS_WRREG_ENABLE		1	/*Enable Write Single Register. Function 6*/
 #define MODBUS_WRMREGS_ENABLE	1	/*Enable Write Multiple Registers. Function 16*/
+#define MODBUS_FILE_ENABLE		0	/*Enable file records access. Functions 20 & 21*/
+#define MODBUS_MSKWRREG_ENABLE	0	/*Enable Mask Write Register. Function 22*/
+#define MODBUS_RDWRMREGS_ENABLE	0	/*Enable Read/Write Multiple Registers. Function 23*/
+#define MODBUS_PDU_CUSTOM_ENABLE	0	/*Custom function handlers registration with MB_PDU_RegisterHandler()*/
+#define MODBUS_STATS_ENABLE		0	/*Server statistics counters and diagnostics. Function 8 (RTU)*/
+#define MODBUS_STATS_FUNC_NUM	24	/*Function codes with own requests counter*/
+#define MODBUS_REGS_ATOMIC_WR	1	/*All-or-nothing registers write with single update notification*/
+#define MODBUS_REGS_DIRTY_ENABLE	1	/*Changed registers tracking*/
+#define MODBUS_REGS_SUBSCR_NUM	4	/*Registers changes subscribers number*/
+#define MODBUS_REGS_UPDQ_ENABLE	1	/*Process registers updates out of request context*/
+#define MODBUS_REGS_UPDQ_LEN	64	/*Registers updates queue length. Power of 2*/
+#define MODBUS_NVM_ENABLE		0	/*Non-volatile registers storage journal*/
+#define MODBUS_NVM_FLUSH_DELAY	1000	/*Delay from first change to storage write, ms*/
+
+#define MODBUS_MASTER_REQ_NUM	8	/*Master requests pool size*/
+#define MODBUS_MASTER_REQ_RSV	2	/*Requests reserved for urgent and control lanes*/
+#define MODBUS_RESPONSE_TIMEOUT	100	/*Master response timeout, ms*/
+#define MODBUS_MASTER_MIN_TIMEOUT	10	/*Minimum adaptive response timeout, ms*/
+#define MODBUS_MASTER_SLAVE_NUM	32	/*Highest slave address with tracked response time and quarantine per master (up to 247)*/
+#define MODBUS_MASTER_RETRIES	2	/*Request retries on timeout or CRC error*/
+#define MODBUS_MASTER_RETRY_DELAY	10	/*First retry delay, doubled for each next retry, ms*/
+#define MODBUS_MASTER_QUAR_FAILS	3	/*Failed requests in a row to quarantine slave*/
+#define MODBUS_MASTER_QUAR_PROBE	5000	/*Quarantined slave probe period, ms*/
+#define MODBUS_TCP_CLIENT_REQ_NUM	8	/*Requests number of TCP client connection*/
+#define MODBUS_MASTER_RX_STAGED	0	/*Master receives response header first to finish exceptions and short frames early*/
 
 #define MODBUS_TRACE_ENABLE 	0	/*Enable Trace*/
+#define MODBUS_BTRACE_ENABLE	0	/*Binary events trace to per-port ring buffers*/
+#define MODBUS_BTRACE_LEN		64	/*Trace records per port. Power of 2*/
 #define MODBUS_RXWAIT_TIME		5
 
 #if MODBUS_TRACE_ENABLE
@@ -43,8 +70,16 @@
 
 #define MODBUS_GET_TICK			HAL_GetTick()
 
+#ifndef MODBUS_BTRACE_TIME
+#define MODBUS_BTRACE_TIME		MODBUS_GET_TICK	/*Trace timestamp. May be mapped to cycles counter*/
+#endif
+
 #define MB_ASSERT				assert
 
+#ifndef MB_MEM_BARRIER
+#define MB_MEM_BARRIER()		__sync_synchronize()	/*Memory barrier for lock-free queues*/
+#endif
+
 typedef uint8_t MBerror;			/*Error type*/
 
 #endif /* MODBUS_CONF_H_ */
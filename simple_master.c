@@ -1,15 +1,53 @@
 #include "simple_master.h"
 #include "mb_crc.h"
+#include "mb_bitmap.h"
 #include <string.h>
 
-MBerror SiMasterReceive(mb_master_t *mb, uint32_t len);
-MBerror SiMasterPDUSend(mb_master_t *mb, uint8_t slave, uint8_t func, uint32_t len);
-MBerror SiMasterCheckException(mb_master_t *mb);
-MBerror SiMasterWaitForResponse(mb_master_t *mb, uint32_t timeout);
+#define MBRTU_TRACE			MODBUS_TRACE
+#define MBRTU_TRACE_ERR		MODBUS_TRACE
+
+/**
+ * @brief Response header length: slave address, function code and byte count or exception code
+ */
+#define SIMASTER_HDR_LEN	3
+
+/**
+ * @brief Maximum response time sample, ms. Keeps smoothed values of slave state in 16 bits
+ */
+#define SIMASTER_RTT_MAX	4095
+
+/**
+ * @brief Requests pool shared by all masters
+ */
+static SiMasterReq_t SiMasterPool[MODBUS_MASTER_REQ_NUM];
+static SiMasterReq_t *SiMasterFree = NULL;
+static uint32_t SiMasterFreeNum = 0;
+static uint8_t SiMasterPoolInited = 0;
+
+static MBerror SiMasterCheckRtuReq(const SiMasterReq_t *req);
+static MBerror SiMasterStart(mb_master_t *mb, SiMasterReq_t *req);
+static MBerror SiMasterFinish(mb_master_t *mb, const SiMasterReq_t *req, uint32_t len);
+static uint32_t SiMasterTimeoutLen(mb_master_t *mb);
+static MBerror SiMasterTransfer(mb_master_t *mb, SiMasterReq_t *req);
+static MBerror SiMasterWait(mb_master_t *mb, SiMasterReq_t *req);
+static void SiMasterComplete(mb_master_t *mb, SiMasterReq_t *req, MBerror err);
+static void SiMasterNext(mb_master_t *mb);
+static uint8_t SiMasterRetry(mb_master_t *mb, SiMasterReq_t *req, MBerror err);
+static uint32_t SiMasterRetryDelay(const SiMasterReq_t *req);
+static SiMasterSlave_t *SiMasterSlave(mb_master_t *mb, uint8_t slave);
+static uint32_t SiMasterLenTime(const SiMasterReq_t *req);
+static uint8_t SiMasterHasByteCount(uint8_t func);
+static uint16_t SiMasterFileLen(const SiMasterReq_t *req, uint16_t sub_len);
+static void SiMasterReqFill(SiMasterReq_t *req, uint8_t slave, uint8_t func, uint16_t addr, uint16_t num);
+#if MODBUS_MASTER_RX_STAGED
+static uint32_t SiMasterRxRest(mb_master_t *mb);
+#endif
 
 MBerror SiMasterInit(mb_master_t *mb)
 {
-	if (!mb->wait_for_resp || !mb->itfs_write || !mb->rx_buf || !mb->tx_buf)
+	uint32_t i;
+
+	if (!mb->itfs_write || !mb->itfs_read || !mb->rx_buf || !mb->tx_buf)
 	{
 		MBRTU_TRACE_ERR("Init Problem\r\n");
 
@@ -17,297 +55,1192 @@ MBerror SiMasterInit(mb_master_t *mb)
 	}
 
 	mb->rx_byte = mb->rx_buf;
+	mb->rx_done = 0;
+	mb->retry = 0;
+	mb->cur = NULL;
+	for (i = 0; i < SIMASTER_PRIO_NUM; i++)
+	{
+		mb->head[i] = NULL;
+		mb->tail[i] = NULL;
+	}
+
+#if MODBUS_MASTER_SLAVE_NUM
+	memset(mb->slaves, 0, sizeof(mb->slaves));
+#endif
+
+	if (!SiMasterPoolInited)
+	{
+		for (i = 0; i < MODBUS_MASTER_REQ_NUM; i++)
+		{
+			SiMasterPool[i].next = SiMasterFree;
+			SiMasterFree = &SiMasterPool[i];
+		}
+
+		SiMasterFreeNum = MODBUS_MASTER_REQ_NUM;
+
+		SiMasterPoolInited = 1;
+	}
 
 	MBRTU_TRACE("Starting ModBus Master RTU\r\n");
 
 	return MODBUS_ERR_OK;
 }
 
+/* Function 01 (0x01) Read Coils*/
+MBerror SiMasterReadCoils(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDCOIL, addr, num);
+	req.bits = bits;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 02 (0x02) Read Discrete Inputs*/
+MBerror SiMasterReadDInputs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDDINP, addr, num);
+	req.bits = bits;
+
+	return SiMasterTransfer(mb, &req);
+}
+
 /* Function 03 (0x03) Read Holding Registers*/
 MBerror SiMasterReadHRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val)
 {
-	MBerror err = MODBUS_ERR_OK;
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDHLDREGS, addr, num);
+	req.val = val;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 04 (0x04) Read Input Registers*/
+MBerror SiMasterReadIRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDINREGS, addr, num);
+	req.val = val;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 05 (0x05) Write Single Coil*/
+MBerror SiMasterWriteCoil(mb_master_t *mb, uint8_t slave, uint16_t addr, uint8_t val)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_WRSCOIL, addr, 1);
+	req.bits = &val;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 06 (0x06) Write Single Register*/
+MBerror SiMasterWriteReg(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t val)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_WRSREG, addr, 1);
+	req.val = &val;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 15 (0x0F) Write Multiple Coils*/
+MBerror SiMasterWriteMCoils(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_WRMCOILS, addr, num);
+	req.bits = bits;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 16 (0x10) Write Multiple Registers*/
+MBerror SiMasterWriteMRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_WRMREGS, addr, num);
+	req.val = val;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 23 (0x17) Read/Write Multiple Registers. Write is done before read*/
+MBerror SiMasterReadWriteRegs(mb_master_t *mb, uint8_t slave, uint16_t rd_addr, uint16_t rd_num, uint16_t *rd_val,
+							  uint16_t wr_addr, uint16_t wr_num, uint16_t *wr_val)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDWRMREGS, rd_addr, rd_num);
+	req.val = rd_val;
+	req.wr_addr = wr_addr;
+	req.wr_num = wr_num;
+	req.wr_val = wr_val;
 
-	if (num < 1 || num > 125) return MODBUS_ERR_VALUE;
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 20 (0x14) Read File Record. Records of all sub-requests are read in one transaction*/
+MBerror SiMasterReadFile(mb_master_t *mb, uint8_t slave, SiMasterFileRec_t *recs, uint16_t num)
+{
+	SiMasterReq_t req;
 
-	U162ARR(addr, &mb->tx_buf[2]); //starting address
-	U162ARR(num, &mb->tx_buf[4]); //Quantity of registers
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_RDFILE, 0, num);
+	req.recs = recs;
 
-	/*Send PDU*/
-	err = SiMasterPDUSend(mb, slave, MODBUS_FUNC_RDHLDREGS, 4);
+	return SiMasterTransfer(mb, &req);
+}
+
+/* Function 21 (0x15) Write File Record*/
+MBerror SiMasterWriteFile(mb_master_t *mb, uint8_t slave, SiMasterFileRec_t *recs, uint16_t num)
+{
+	SiMasterReq_t req;
+
+	SiMasterReqFill(&req, slave, MODBUS_FUNC_WRFILE, 0, num);
+	req.recs = recs;
+
+	return SiMasterTransfer(mb, &req);
+}
+
+/**
+ * @brief       Queues request to its priority lane. Request is copied to requests pool, so it may be
+ *              located on stack. Must be called from the same context as SiMasterPoll().
+ *              Background scans leave MODBUS_MASTER_REQ_RSV requests for higher priorities.
+ *              If master is idle, request is started at once and callback of request
+ *              completed on start is called before return.
+ * @param mb    Master handle
+ * @param req   Request
+ * @return      Error code. MODBUS_ERR_BUSY if there is no free request in pool.
+ */
+MBerror SiMasterSubmit(mb_master_t *mb, const SiMasterReq_t *req)
+{
+	SiMasterReq_t *r;
+	MBerror err = SiMasterCheckRtuReq(req);
 
-	if (err != MODBUS_ERR_OK) {
-		MBRTU_TRACE_ERR("Tx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
+	if (err != MODBUS_ERR_OK)
+	{
 		return err;
 	}
 
-	/*Start receiving*/
-	if (SiMasterReceive(mb, 3 + num*2 + 2) != MODBUS_ERR_OK)
+	if (req->prio >= SIMASTER_PRIO_NUM)
 	{
-		MBRTU_TRACE_ERR("Rx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
-		return MODBUS_ERR_INTFS;
+		return MODBUS_ERR_VALUE;
 	}
 
-	/*wait for response*/
-	if ((SiMasterWaitForResponse(mb, MODBUS_RESPONSE_TIMEOUT + num*2) != MODBUS_ERR_OK) &&
-			(mb->rx_buf[0] == 0))
+	if ((SiMasterFree == NULL) ||
+		((req->prio == SIMASTER_PRIO_SCAN) && (SiMasterFreeNum <= MODBUS_MASTER_REQ_RSV)))
 	{
-		MBRTU_TRACE_ERR("Response timeout: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
-		return MODBUS_ERR_TIMEOUT;
+		return MODBUS_ERR_BUSY;
 	}
 
-	if (mb->rx_buf[0] == slave)
+	r = SiMasterFree;
+	SiMasterFree = r->next;
+	SiMasterFreeNum--;
+
+	*r = *req;
+	r->next = NULL;
+	r->tries = 0;
+
+	if (mb->tail[r->prio] != NULL)
+	{
+		mb->tail[r->prio]->next = r;
+	}
+	else
 	{
-		/*Check for exception*/
-		err = SiMasterCheckException(mb);
+		mb->head[r->prio] = r;
+	}
 
-		if (err != MODBUS_ERR_OK)
-		{
-			MBRTU_TRACE_ERR("Rx exception %d: Slave %d, Func %d\r\n", err, slave, MODBUS_FUNC_RDHLDREGS);
-			return err;
-		}
+	mb->tail[r->prio] = r;
 
-		if (mb->rx_buf[1] == MODBUS_FUNC_RDHLDREGS)
+	if (mb->cur == NULL)
+	{
+		SiMasterNext(mb);
+	}
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Reception complete callback. Call it from interface driver (ISR)
+ *              when requested number of bytes or end of frame has been received.
+ *              In staged mode reception of the rest of frame is started on header reception,
+ *              so itfs_read() is called from this callback.
+ * @param mb    Master handle
+ * @param len   Number of bytes received by the last itfs_read() call
+ */
+void SiMasterRxCmplt(mb_master_t *mb, uint32_t len)
+{
+#if MODBUS_MASTER_RX_STAGED
+	uint32_t rest;
+
+	if (mb->rx_stage == 1)
+	{
+		mb->rx_stage = 2;
+
+		if (len >= SIMASTER_HDR_LEN)
 		{
-			/*Check CRC*/
-			if (ModRTU_CRC(mb->rx_buf, 3 + num*2) != ARR2U16(&mb->rx_buf[3 + num*2]))
-			{
-				MBRTU_TRACE_ERR("Rx CRC error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
-				return MODBUS_ERR_CRC;
-			}
+			rest = SiMasterRxRest(mb);
+			mb->rx_wait_len = SIMASTER_HDR_LEN + rest;
+			mb->rx_byte = mb->rx_buf + SIMASTER_HDR_LEN;
 
-			/*Copy values*/
-			for (int i = 0; i < num; i++)
+			if (mb->itfs_read(rest) == MODBUS_ERR_OK)
 			{
-				val[i] = ARR2U16(&mb->rx_buf[3 + i*2]);
+				return;
 			}
+		}
+	}
+	else
+	{
+		len += SIMASTER_HDR_LEN;
+	}
+#endif
 
-			return MODBUS_ERR_OK;
+	mb->rx_len = len;
+	mb->rx_tick = MODBUS_GET_TICK;
+	MB_MEM_BARRIER();
+	mb->rx_done = 1;
+}
+
+/**
+ * @brief       Drives queued requests: completes current request on reception or
+ *              timeout, retries it or calls its callback and starts next request.
+ *              Call it periodically.
+ * @param mb    Master handle
+ */
+void SiMasterPoll(mb_master_t *mb)
+{
+	SiMasterReq_t *req = mb->cur;
+	MBerror err;
+
+	if (req == NULL)
+	{
+		SiMasterNext(mb);
+		return;
+	}
+
+	if (mb->retry)
+	{
+		if ((int32_t) (MODBUS_GET_TICK - mb->retry_tick) < 0)
+		{
+			return;
 		}
-		else
+
+		mb->retry = 0;
+		err = SiMasterStart(mb, req);
+
+		if (err == MODBUS_ERR_OK)
 		{
-			MBRTU_TRACE_ERR("Incorrect func response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
-			return MODBUS_ERR_VALUE;
+			return;
 		}
 	}
+	else if (mb->rx_done)
+	{
+		err = SiMasterFinish(mb, req, mb->rx_len);
+	}
+	else if ((uint32_t) (MODBUS_GET_TICK - mb->start_tick) >= mb->timeout)
+	{
+		if (mb->itfs_abort)
+		{
+			mb->itfs_abort();
+		}
+
+		err = SiMasterFinish(mb, req, SiMasterTimeoutLen(mb));
+	}
 	else
 	{
-		MBRTU_TRACE_ERR("Incorrect slave response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_RDHLDREGS);
-		return MODBUS_ERR_VALUE; //may be another error?
+		return;
 	}
 
-	return err;
+	if (SiMasterRetry(mb, req, err))
+	{
+		mb->retry_tick = MODBUS_GET_TICK + SiMasterRetryDelay(req);
+		mb->retry = 1;
+		return;
+	}
+
+	SiMasterComplete(mb, req, err);
+	SiMasterNext(mb);
 }
 
-/* Function 06 (0x06) Write Single Register*/
-MBerror SiMasterWriteReg(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t val)
+/**
+ * @brief       Checks that master has no request in progress or queued
+ * @param mb    Master handle
+ * @return      1 if master is idle
+ */
+uint8_t SiMasterIdle(const mb_master_t *mb)
 {
-	MBerror err = MODBUS_ERR_OK;
 	uint32_t i;
 
-	U162ARR(addr, &mb->tx_buf[2]); //address
-	U162ARR(val, &mb->tx_buf[4]); //value
+	if (mb->cur != NULL)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < SIMASTER_PRIO_NUM; i++)
+	{
+		if (mb->head[i] != NULL)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
 
-	/*Send PDU*/
-	err = SiMasterPDUSend(mb, slave, MODBUS_FUNC_WRSREG, 4);
+/**
+ * @brief       Resets response time statistics and quarantine of slave
+ * @param mb    Master handle
+ * @param slave Slave address
+ */
+void SiMasterSlaveReset(mb_master_t *mb, uint8_t slave)
+{
+	SiMasterSlave_t *sl = SiMasterSlave(mb, slave);
 
-	if (err != MODBUS_ERR_OK) {
-		MBRTU_TRACE_ERR("Tx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-		return err;
+	if (sl != NULL)
+	{
+		memset(sl, 0, sizeof(*sl));
 	}
+}
 
-	/*Start receiving*/
-	if (SiMasterReceive(mb, 6 + 2) != MODBUS_ERR_OK)
+/**
+ * @brief       Builds request PDU (function code and data)
+ * @param req   Request
+ * @param pdu   Pointer to PDU buffer
+ * @return      PDU length, 0 if request is incorrect
+ */
+uint16_t SiMasterPDUBuild(const SiMasterReq_t *req, uint8_t *pdu)
+{
+	uint16_t i, bc;
+
+	if (SiMasterCheckReq(req) != MODBUS_ERR_OK)
 	{
-		MBRTU_TRACE_ERR("Rx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-		return MODBUS_ERR_INTFS;
+		return 0;
 	}
 
-	/*wait for response*/
-	if ((SiMasterWaitForResponse(mb, MODBUS_RESPONSE_TIMEOUT) != MODBUS_ERR_OK) &&
-			(mb->rx_buf[0] == 0))
+	pdu[0] = req->func;
+	U162ARR(req->addr, &pdu[1]); //starting address
+
+	switch (req->func)
 	{
-		MBRTU_TRACE_ERR("Response timeout: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-		return MODBUS_ERR_TIMEOUT;
+		case MODBUS_FUNC_RDCOIL:
+		case MODBUS_FUNC_RDDINP:
+		case MODBUS_FUNC_RDHLDREGS:
+		case MODBUS_FUNC_RDINREGS:
+			U162ARR(req->num, &pdu[3]); //Quantity of coils/inputs/registers
+			return 5;
+
+		case MODBUS_FUNC_WRSCOIL:
+			U162ARR((req->bits[0] & 1) ? 0xFF00 : 0x0000, &pdu[3]); //coil value
+			return 5;
+
+		case MODBUS_FUNC_WRSREG:
+			U162ARR(req->val[0], &pdu[3]); //value
+			return 5;
+
+		case MODBUS_FUNC_WRMCOILS:
+			bc = (uint16_t) ((req->num + 7) / 8);
+			U162ARR(req->num, &pdu[3]); //Quantity of coils
+			pdu[5] = (uint8_t) bc; //byte count
+			memcpy(&pdu[6], req->bits, bc);
+
+			if (req->num & 7)
+			{
+				/*unused bits of the last byte are zero*/
+				pdu[5 + bc] &= (uint8_t) ((1U << (req->num & 7)) - 1);
+			}
+
+			return (uint16_t) (6 + bc);
+
+		case MODBUS_FUNC_WRMREGS:
+			U162ARR(req->num, &pdu[3]); //Quantity of registers
+			pdu[5] = (uint8_t) (2*req->num); //byte count
+
+			for (i = 0; i < req->num; i++)
+			{
+				U162ARR(req->val[i], &pdu[6 + 2*i]);
+			}
+
+			return (uint16_t) (6 + 2*req->num);
+
+		case MODBUS_FUNC_RDWRMREGS:
+			U162ARR(req->num, &pdu[3]); //Quantity to read
+			U162ARR(req->wr_addr, &pdu[5]); //write starting address
+			U162ARR(req->wr_num, &pdu[7]); //Quantity to write
+			pdu[9] = (uint8_t) (2*req->wr_num); //byte count
+
+			for (i = 0; i < req->wr_num; i++)
+			{
+				U162ARR(req->wr_val[i], &pdu[10 + 2*i]);
+			}
+
+			return (uint16_t) (10 + 2*req->wr_num);
+
+		case MODBUS_FUNC_RDFILE:
+		case MODBUS_FUNC_WRFILE:
+			bc = 2;
+
+			for (i = 0; i < req->num; i++)
+			{
+				const SiMasterFileRec_t *rec = &req->recs[i];
+				uint16_t j;
+
+				pdu[bc] = MB_FILE_REF_TYPE;
+				U162ARR(rec->file, &pdu[bc + 1]);
+				U162ARR(rec->record, &pdu[bc + 3]);
+				U162ARR(rec->num, &pdu[bc + 5]);
+				bc += 7;
+
+				if (req->func == MODBUS_FUNC_WRFILE)
+				{
+					for (j = 0; j < rec->num; j++)
+					{
+						U162ARR(rec->val[j], &pdu[bc + 2*j]);
+					}
+
+					bc += 2*rec->num;
+				}
+			}
+
+			pdu[1] = (uint8_t) (bc - 2); //byte count
+
+			return bc;
+
+		default:
+			return 0;
 	}
+}
 
-	if (mb->rx_buf[0] == slave)
+/**
+ * @brief       Returns expected length of normal response PDU
+ * @param req   Request
+ * @return      Response PDU length
+ */
+uint16_t SiMasterPDURespLen(const SiMasterReq_t *req)
+{
+	switch (req->func)
 	{
-		/*Check for exception*/
-		err = SiMasterCheckException(mb);
+		case MODBUS_FUNC_RDCOIL:
+		case MODBUS_FUNC_RDDINP:
+			return (uint16_t) (2 + (req->num + 7) / 8);
 
-		if (err != MODBUS_ERR_OK)
-		{
-			MBRTU_TRACE_ERR("Rx exception %d: Slave %d, Func %d\r\n", err, slave, MODBUS_FUNC_WRSREG);
-			return err;
-		}
+		case MODBUS_FUNC_RDHLDREGS:
+		case MODBUS_FUNC_RDINREGS:
+		case MODBUS_FUNC_RDWRMREGS:
+			return (uint16_t) (2 + 2*req->num);
 
-		if (mb->rx_buf[1] == MODBUS_FUNC_WRSREG)
-		{
-			/*Check CRC*/
-			if (ModRTU_CRC(mb->rx_buf, 6) != ARR2U16(&mb->rx_buf[6]))
+		case MODBUS_FUNC_RDFILE:
+			/*File response length and reference type of every sub-request*/
+			return SiMasterFileLen(req, 2);
+
+		case MODBUS_FUNC_WRFILE:
+			/*Echo of request*/
+			return SiMasterFileLen(req, 7);
+
+		default:
+			/*Write requests echo address and value/quantity*/
+			return 5;
+	}
+}
+
+/**
+ * @brief       Checks response PDU and copies read values
+ * @param req   Request
+ * @param pdu   Pointer to response PDU
+ * @param len   Response PDU length
+ * @return      Error code or exception code of slave
+ */
+MBerror SiMasterPDUParse(const SiMasterReq_t *req, const uint8_t *pdu, uint16_t len)
+{
+	uint16_t i;
+
+	/*Check for exception*/
+	if ((len == 2) && (pdu[0] == (req->func | 0x80)))
+	{
+		return pdu[1]; //exception code
+	}
+
+	if ((len < 1) || (pdu[0] != req->func))
+	{
+		MBRTU_TRACE_ERR("Incorrect func response: Slave %d, Func %d\r\n", req->slave, req->func);
+		return MODBUS_ERR_VALUE;
+	}
+
+	switch (req->func)
+	{
+		case MODBUS_FUNC_RDCOIL:
+		case MODBUS_FUNC_RDDINP:
+			if ((len != SiMasterPDURespLen(req)) || (pdu[1] != len - 2))
+			{
+				return MODBUS_ERR_VALUE;
+			}
+
+			/*Copy packed bits*/
+			memcpy(req->bits, &pdu[2], pdu[1]);
+
+			return MODBUS_ERR_OK;
+
+		case MODBUS_FUNC_RDHLDREGS:
+		case MODBUS_FUNC_RDINREGS:
+		case MODBUS_FUNC_RDWRMREGS:
+			if ((len != 2 + 2*req->num) || (pdu[1] != 2*req->num))
+			{
+				return MODBUS_ERR_VALUE;
+			}
+
+			/*Copy values*/
+			for (i = 0; i < req->num; i++)
+			{
+				req->val[i] = ARR2U16(&pdu[2 + i*2]);
+			}
+
+			return MODBUS_ERR_OK;
+
+		case MODBUS_FUNC_WRSCOIL:
+			/*compare request and response. Must be the same*/
+			if ((len != 5) || ((ARR2U16(&pdu[1])) != req->addr) ||
+				((ARR2U16(&pdu[3])) != ((req->bits[0] & 1) ? 0xFF00 : 0x0000)))
 			{
-				MBRTU_TRACE_ERR("Rx CRC error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-				return MODBUS_ERR_CRC;
+				return MODBUS_ERR_VALUE;
 			}
 
+			return MODBUS_ERR_OK;
+
+		case MODBUS_FUNC_WRSREG:
 			/*compare request and response. Must be the same*/
-			for (i = 0; i < 6; i++)
+			if ((len != 5) || ((ARR2U16(&pdu[1])) != req->addr) || ((ARR2U16(&pdu[3])) != req->val[0]))
+			{
+				return MODBUS_ERR_VALUE;
+			}
+
+			return MODBUS_ERR_OK;
+
+		case MODBUS_FUNC_WRMCOILS:
+		case MODBUS_FUNC_WRMREGS:
+			/*compare address and quantity of request and response*/
+			if ((len != 5) || ((ARR2U16(&pdu[1])) != req->addr) || ((ARR2U16(&pdu[3])) != req->num))
+			{
+				return MODBUS_ERR_VALUE;
+			}
+
+			return MODBUS_ERR_OK;
+
+		case MODBUS_FUNC_RDFILE:
+		case MODBUS_FUNC_WRFILE:
+			if ((len != SiMasterPDURespLen(req)) || (pdu[1] != len - 2))
+			{
+				return MODBUS_ERR_VALUE;
+			}
+
+			pdu += 2;
+
+			for (i = 0; i < req->num; i++)
 			{
-				if (mb->rx_buf[i] != mb->tx_buf[i])
+				const SiMasterFileRec_t *rec = &req->recs[i];
+				uint16_t j;
+
+				if (req->func == MODBUS_FUNC_RDFILE)
 				{
-					err = MODBUS_ERR_VALUE;
-					break;
+					if ((pdu[0] != 1 + 2*rec->num) || (pdu[1] != MB_FILE_REF_TYPE))
+					{
+						return MODBUS_ERR_VALUE;
+					}
+
+					for (j = 0; j < rec->num; j++)
+					{
+						rec->val[j] = ARR2U16(&pdu[2 + 2*j]);
+					}
+
+					pdu += 2 + 2*rec->num;
+				}
+				else
+				{
+					/*compare sub-request header, written data isn't checked*/
+					if ((pdu[0] != MB_FILE_REF_TYPE) || ((ARR2U16(&pdu[1])) != rec->file) ||
+						((ARR2U16(&pdu[3])) != rec->record) || ((ARR2U16(&pdu[5])) != rec->num))
+					{
+						return MODBUS_ERR_VALUE;
+					}
+
+					pdu += 7 + 2*rec->num;
 				}
 			}
+
+			return MODBUS_ERR_OK;
+
+		default:
+			return MODBUS_ERR_VALUE;
+	}
+}
+
+/**
+ * @brief           Plans read requests covering wanted registers with minimal number of requests.
+ *                  Neighbour ranges are merged if there are no more than gap unwanted registers
+ *                  between them, all merged registers are readable and request fits 125 registers.
+ * @param addr      Wanted registers addresses sorted in ascending order
+ * @param num       Wanted registers number
+ * @param rd_map    Readable registers of the slave (bit per register) or NULL if all are readable
+ * @param gap       Maximum number of unwanted registers read to merge two ranges
+ * @param plan      Pointer to read requests storage array
+ * @param plan_num  Pointer to plan size: array size on input, read requests number on output
+ * @return          Error code
+ */
+MBerror SiMasterPlanReads(const uint16_t *addr, uint16_t num, const uint32_t *rd_map, uint16_t gap,
+						  SiMasterRange_t *plan, uint16_t *plan_num)
+{
+	uint16_t max = *plan_num;
+	uint16_t cnt = 0;
+	uint32_t end = 0;
+	uint16_t i;
+
+	for (i = 0; i < num; i++)
+	{
+		if ((cnt > 0) && (addr[i] < end))
+		{
+			/*Duplicated address*/
+			continue;
+		}
+
+		if ((cnt > 0) && (addr[i] - end <= gap) && (addr[i] - plan[cnt - 1].addr < 125) &&
+			((rd_map == NULL) || MBBitmapTest(rd_map, (uint16_t) end, (uint16_t) (addr[i] - end + 1))))
+		{
+			/*Extend current request*/
+			plan[cnt - 1].num = (uint16_t) (addr[i] - plan[cnt - 1].addr + 1);
 		}
 		else
 		{
-			MBRTU_TRACE_ERR("Incorrect func response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-			return MODBUS_ERR_VALUE;
+			if (cnt >= max)
+			{
+				*plan_num = cnt;
+				return MODBUS_ERR_SYS;
+			}
+
+			plan[cnt].addr = addr[i];
+			plan[cnt].num = 1;
+			cnt++;
 		}
 
+		end = (uint32_t) addr[i] + 1;
 	}
-	else
+
+	*plan_num = cnt;
+
+	return MODBUS_ERR_OK;
+}
+
+/**
+ * @brief       Checks request function code and parameters
+ * @param req   Request
+ * @return      Error code
+ */
+MBerror SiMasterCheckReq(const SiMasterReq_t *req)
+{
+	switch (req->func)
 	{
-		MBRTU_TRACE_ERR("Incorrect slave response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRSREG);
-		return MODBUS_ERR_VALUE; //may be another error?
+		case MODBUS_FUNC_RDCOIL:
+		case MODBUS_FUNC_RDDINP:
+			if (req->num < 1 || req->num > 2000 || req->bits == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_RDHLDREGS:
+		case MODBUS_FUNC_RDINREGS:
+			if (req->num < 1 || req->num > 125 || req->val == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_WRSCOIL:
+			if (req->bits == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_WRSREG:
+			if (req->val == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_WRMCOILS:
+			if (req->num < 1 || req->num > 1968 || req->bits == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_WRMREGS:
+			if (req->num < 1 || req->num > 123 || req->val == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_RDWRMREGS:
+			if (req->num < 1 || req->num > 125 || req->val == NULL) return MODBUS_ERR_VALUE;
+			if (req->wr_num < 1 || req->wr_num > 121 || req->wr_val == NULL) return MODBUS_ERR_VALUE;
+			break;
+
+		case MODBUS_FUNC_RDFILE:
+		case MODBUS_FUNC_WRFILE:
+		{
+			uint16_t i;
+
+			if (req->num < 1 || req->num > 35 || req->recs == NULL) return MODBUS_ERR_VALUE;
+
+			for (i = 0; i < req->num; i++)
+			{
+				if (req->recs[i].num < 1 || req->recs[i].record > MB_FILE_MAX_RECORD || req->recs[i].val == NULL)
+				{
+					return MODBUS_ERR_VALUE;
+				}
+			}
+
+			/*Request and response must fit PDU*/
+			if (SiMasterFileLen(req, 7) > MB_PDU_MAX_LEN || SiMasterFileLen(req, 2) > MB_PDU_MAX_LEN)
+			{
+				return MODBUS_ERR_VALUE;
+			}
+			break;
+		}
+
+		default:
+			return MODBUS_ERR_ILLEGFUNC;
 	}
 
-	return err;
+	return MODBUS_ERR_OK;
 }
 
-/* Function 16 (0x10) Write Multiple Registers*/
-MBerror SiMasterWriteMRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val)
+/*Checks RTU request parameters. Broadcast is allowed for write requests only*/
+static MBerror SiMasterCheckRtuReq(const SiMasterReq_t *req)
 {
-	MBerror err = MODBUS_ERR_OK;
-	uint32_t i;
+	if ((req->slave == 0) && SiMasterHasByteCount(req->func))
+	{
+		return MODBUS_ERR_VALUE;
+	}
 
-	if (num < 1 || num > 123) return MODBUS_ERR_VALUE;
+	return SiMasterCheckReq(req);
+}
 
-	U162ARR(addr, &mb->tx_buf[2]); //starting address
-	U162ARR(num, &mb->tx_buf[4]); //Quantity of registers
-	mb->tx_buf[6] = 2*num; //byte count
+/*Prepares packet, sends it and starts receiver*/
+static MBerror SiMasterStart(mb_master_t *mb, SiMasterReq_t *req)
+{
+	SiMasterSlave_t *sl = SiMasterSlave(mb, req->slave);
+	uint16_t len = SiMasterPDUBuild(req, &mb->tx_buf[1]);
+	uint32_t rto = MODBUS_RESPONSE_TIMEOUT;
+	uint16_t crc;
 
-	/*copy values to tx buffer*/
-	memcpy(&mb->tx_buf[7], val, 2*num);
+	if (len == 0)
+	{
+		return MODBUS_ERR_VALUE;
+	}
 
-	/*Send PDU*/
-	err = SiMasterPDUSend(mb, slave, MODBUS_FUNC_WRMREGS, 5 + 2*num);
+	if (sl != NULL)
+	{
+		if (sl->offline)
+		{
+			/*Quarantined slave gets a single request per probe period*/
+			if ((uint32_t) (MODBUS_GET_TICK - sl->probe_tick) < MODBUS_MASTER_QUAR_PROBE)
+			{
+				return MODBUS_ERR_OFFLINE;
+			}
 
-	if (err != MODBUS_ERR_OK) {
-		MBRTU_TRACE_ERR("Tx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
-		return err;
+			sl->probe_tick = MODBUS_GET_TICK;
+		}
+		else if (sl->srtt != 0)
+		{
+			/*Adaptive timeout: smoothed response time + 4 deviations*/
+			rto = (sl->srtt >> 3) + sl->rttvar;
+			rto = (rto < MODBUS_MASTER_MIN_TIMEOUT) ? MODBUS_MASTER_MIN_TIMEOUT :
+				  (rto > MODBUS_RESPONSE_TIMEOUT) ? MODBUS_RESPONSE_TIMEOUT : rto;
+		}
 	}
 
-	/*Start receiving*/
-	if (SiMasterReceive(mb, 6 + 2) != MODBUS_ERR_OK)
+	mb->tx_buf[0] = req->slave; //slave address
+
+	crc = MBRTU_CRC(mb->tx_buf, len + 1); //CRC for all data
+	U162ARR(crc, &mb->tx_buf[len + 1]);
+
+	mb->rx_done = 0;
+	mb->rx_len = 0;
+	mb->rx_wait_len = (req->slave != 0) ? 1 + SiMasterPDURespLen(req) + 2 : 0;
+	mb->timeout = rto + SiMasterLenTime(req);
+
+	if (mb->itfs_write(mb->tx_buf, len + 1 + 2) != MODBUS_ERR_OK)
 	{
-		MBRTU_TRACE_ERR("Rx error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
+		MBRTU_TRACE_ERR("Tx error: Slave %d, Func %d\r\n", req->slave, req->func);
 		return MODBUS_ERR_INTFS;
 	}
 
-	/*wait for response*/
-	if ((SiMasterWaitForResponse(mb, MODBUS_RESPONSE_TIMEOUT + 2*num) != MODBUS_ERR_OK) &&
-			(mb->rx_buf[0] == 0))
+	mb->start_tick = MODBUS_GET_TICK;
+
+	if (req->slave == 0)
+	{
+		/*Broadcast request has no response*/
+		return MODBUS_ERR_OK;
+	}
+
+	/*clear rx buffer*/
+	memset(mb->rx_buf, 0, mb->rx_wait_len);
+	mb->rx_byte = mb->rx_buf;
+
+	/*start receiving*/
+#if MODBUS_MASTER_RX_STAGED
+	mb->rx_stage = 1;
+	if (mb->itfs_read(SIMASTER_HDR_LEN) != MODBUS_ERR_OK)
+#else
+	if (mb->itfs_read(mb->rx_wait_len) != MODBUS_ERR_OK)
+#endif
 	{
-		MBRTU_TRACE_ERR("Response timeout: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
+		MBRTU_TRACE_ERR("Rx error: Slave %d, Func %d\r\n", req->slave, req->func);
+		return MODBUS_ERR_INTFS;
+	}
+
+	return MODBUS_ERR_OK;
+}
+
+/*Checks received frame*/
+static MBerror SiMasterFinish(mb_master_t *mb, const SiMasterReq_t *req, uint32_t len)
+{
+	uint8_t *rx = mb->rx_buf;
+
+	/*Exception response is shorter than normal one*/
+	if ((len >= 5) && (rx[1] & 0x80))
+	{
+		len = 5;
+	}
+	else if (len < mb->rx_wait_len)
+	{
+		MBRTU_TRACE_ERR("Response timeout: Slave %d, Func %d\r\n", req->slave, req->func);
 		return MODBUS_ERR_TIMEOUT;
 	}
+	else
+	{
+		len = mb->rx_wait_len;
+	}
+
+	if (rx[0] != req->slave)
+	{
+		MBRTU_TRACE_ERR("Incorrect slave response: Slave %d, Func %d\r\n", req->slave, req->func);
+		return MODBUS_ERR_VALUE;
+	}
+
+	/*Check CRC*/
+	if (MBRTU_CRC(rx, len - 2) != (ARR2U16(&rx[len - 2])))
+	{
+		MBRTU_TRACE_ERR("Rx CRC error: Slave %d, Func %d\r\n", req->slave, req->func);
+		return MODBUS_ERR_CRC;
+	}
 
-	if (mb->rx_buf[0] == slave)
+	return SiMasterPDUParse(req, &rx[1], (uint16_t) (len - 3));
+}
+
+/*Returns number of bytes received before timeout. Driver without SiMasterRxCmplt() call
+ *leaves only the first bytes of buffer, which is enough for exception response*/
+static uint32_t SiMasterTimeoutLen(mb_master_t *mb)
+{
+	if (mb->rx_done)
 	{
-		/*Check for exception*/
-		err = SiMasterCheckException(mb);
+		return mb->rx_len;
+	}
+
+	return (mb->rx_buf[0] != 0) ? 5 : 0;
+}
 
-		if (err != MODBUS_ERR_OK)
+/*Processes request in blocking mode. Retries wait for backoff delay as queued requests do*/
+static MBerror SiMasterTransfer(mb_master_t *mb, SiMasterReq_t *req)
+{
+	MBerror err = SiMasterCheckRtuReq(req);
+	uint32_t tick;
+
+	if (err != MODBUS_ERR_OK)
+	{
+		return err;
+	}
+
+	if (!mb->wait_for_resp)
+	{
+		return MODBUS_ERR_MASTER;
+	}
+
+	if (!SiMasterIdle(mb))
+	{
+		/*Queued requests are in progress*/
+		return MODBUS_ERR_BUSY;
+	}
+
+	req->tries = 0;
+
+	do
+	{
+		if (req->tries != 0)
+		{
+			tick = MODBUS_GET_TICK;
+			while ((uint32_t) (MODBUS_GET_TICK - tick) < SiMasterRetryDelay(req));
+		}
+
+		err = SiMasterStart(mb, req);
+
+		if ((err != MODBUS_ERR_OK) || (req->slave == 0))
 		{
-			MBRTU_TRACE_ERR("Rx exception %d: Slave %d, Func %d\r\n", err, slave, MODBUS_FUNC_WRMREGS);
 			return err;
 		}
 
-		if (mb->rx_buf[1] == MODBUS_FUNC_WRMREGS)
+		err = SiMasterWait(mb, req);
+	}
+	while (SiMasterRetry(mb, req, err));
+
+	if (err != MODBUS_ERR_OK)
+	{
+		MBRTU_TRACE_ERR("Request error %d: Slave %d, Func %d\r\n", err, req->slave, req->func);
+	}
+
+	return err;
+}
+
+/*Waits for response of blocking request*/
+static MBerror SiMasterWait(mb_master_t *mb, SiMasterReq_t *req)
+{
+	uint32_t len;
+
+	/*wait for response*/
+#if MODBUS_MASTER_RX_STAGED
+	/*Header reception restarts receiver, wait for the rest of frame*/
+	while (!mb->rx_done && ((uint32_t) (MODBUS_GET_TICK - mb->start_tick) < mb->timeout) &&
+		   (mb->wait_for_resp(mb->timeout - (uint32_t) (MODBUS_GET_TICK - mb->start_tick)) == MODBUS_ERR_OK));
+
+	len = SiMasterTimeoutLen(mb);
+#else
+	if (mb->wait_for_resp(mb->timeout) == MODBUS_ERR_OK)
+	{
+		len = mb->rx_done ? mb->rx_len : mb->rx_wait_len;
+	}
+	else
+	{
+		len = SiMasterTimeoutLen(mb);
+	}
+#endif
+
+	return SiMasterFinish(mb, req, len);
+}
+
+/*Calls request callback and returns request to pool*/
+static void SiMasterComplete(mb_master_t *mb, SiMasterReq_t *req, MBerror err)
+{
+	if (req->cb)
+	{
+		/*Requests submitted from callback are queued*/
+		req->cb(err, req);
+	}
+
+	req->next = SiMasterFree;
+	SiMasterFree = req;
+	SiMasterFreeNum++;
+	mb->cur = NULL;
+}
+
+/*Starts next queued request of the highest priority lane*/
+static void SiMasterNext(mb_master_t *mb)
+{
+	SiMasterReq_t *req;
+	uint32_t prio;
+	MBerror err;
+
+	while (mb->cur == NULL)
+	{
+		for (prio = 0; (prio < SIMASTER_PRIO_NUM) && (mb->head[prio] == NULL); prio++);
+
+		if (prio == SIMASTER_PRIO_NUM)
+		{
+			break;
+		}
+
+		req = mb->head[prio];
+		mb->head[prio] = req->next;
+
+		if (mb->head[prio] == NULL)
+		{
+			mb->tail[prio] = NULL;
+		}
+
+		mb->cur = req;
+		err = SiMasterStart(mb, req);
+
+		if ((err != MODBUS_ERR_OK) || (req->slave == 0))
 		{
-			/*Check CRC*/
-			if (ModRTU_CRC(mb->rx_buf, 6) != ARR2U16(&mb->rx_buf[6]))
+			SiMasterComplete(mb, req, err);
+		}
+	}
+}
+
+/*Updates slave state with request result. Returns 1 if request must be retried*/
+static uint8_t SiMasterRetry(mb_master_t *mb, SiMasterReq_t *req, MBerror err)
+{
+	SiMasterSlave_t *sl = SiMasterSlave(mb, req->slave);
+	uint32_t end_tick;
+	int32_t rtt, delta;
+
+	if ((err != MODBUS_ERR_TIMEOUT) && (err != MODBUS_ERR_CRC) && (err != MODBUS_ERR_INTFS))
+	{
+		if ((sl == NULL) || (err == MODBUS_ERR_OFFLINE))
+		{
+			return 0;
+		}
+
+		/*Slave has responded. Response time of retried request is ambiguous*/
+		if ((req->tries == 0) && (err != MODBUS_ERR_VALUE))
+		{
+			/*Poll latency isn't a part of response time. Blocking driver may not report reception*/
+			end_tick = mb->rx_done ? mb->rx_tick : MODBUS_GET_TICK;
+			rtt = (int32_t) (end_tick - mb->start_tick) - (int32_t) SiMasterLenTime(req);
+			rtt = (rtt < 0) ? 0 : (rtt > SIMASTER_RTT_MAX) ? SIMASTER_RTT_MAX : rtt;
+
+			/*Bit 0 of srtt marks measured response time*/
+			if (sl->srtt == 0)
 			{
-				MBRTU_TRACE_ERR("Rx CRC error: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
-				return MODBUS_ERR_CRC;
+				sl->srtt = (uint16_t) ((rtt << 3) | 1);
+				sl->rttvar = (uint16_t) (rtt << 1);
 			}
-
-			/*compare first bytes of request and response*/
-			for (i = 0; i < 6; i++)
+			else
 			{
-				if (mb->rx_buf[i] != mb->tx_buf[i])
-				{
-					err = MODBUS_ERR_VALUE;
-					break;
-				}
+				delta = rtt - (int32_t) (sl->srtt >> 3);
+				sl->srtt = (uint16_t) (((int32_t) sl->srtt + delta) | 1);
+				delta = (delta < 0) ? -delta : delta;
+				sl->rttvar = (uint16_t) ((int32_t) sl->rttvar + delta - (int32_t) (sl->rttvar >> 2));
 			}
 		}
-		else
+
+		if (sl->offline)
 		{
-			MBRTU_TRACE_ERR("Incorrect func response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
-			return MODBUS_ERR_VALUE;
+			MBRTU_TRACE("Slave %d is online\r\n", req->slave);
 		}
+
+		sl->fails = 0;
+		sl->offline = 0;
+
+		return 0;
 	}
-	else
+
+	if ((sl != NULL) && sl->offline)
 	{
-		MBRTU_TRACE_ERR("Incorrect slave response: Slave %d, Func %d\r\n", slave, MODBUS_FUNC_WRMREGS);
-		return MODBUS_ERR_VALUE; //may be another error?
+		/*Failed probe*/
+		return 0;
 	}
 
-	return err;
+	if (req->tries < MODBUS_MASTER_RETRIES)
+	{
+		req->tries++;
+		return 1;
+	}
+
+	if ((sl != NULL) && (++sl->fails >= MODBUS_MASTER_QUAR_FAILS))
+	{
+		MBRTU_TRACE_ERR("Slave %d is quarantined\r\n", req->slave);
+
+		sl->offline = 1;
+		sl->probe_tick = MODBUS_GET_TICK;
+		sl->srtt = 0;
+		sl->rttvar = 0;
+	}
+
+	return 0;
 }
 
-/*Starts receiver*/
-MBerror SiMasterReceive(mb_master_t *mb, uint32_t len)
+/*Returns delay before retry of request, ms. Delay is doubled for each next retry*/
+static uint32_t SiMasterRetryDelay(const SiMasterReq_t *req)
 {
-	/*clear rx buffer*/
-	memset(mb->rx_buf, 0, len);
+	return (uint32_t) MODBUS_MASTER_RETRY_DELAY << (req->tries - 1);
+}
 
-	/*start receiving*/
-	if (mb->itfs_read(len) != MODBUS_ERR_OK)
+/*Returns slave state entry, NULL if state of slave isn't tracked*/
+static SiMasterSlave_t *SiMasterSlave(mb_master_t *mb, uint8_t slave)
+{
+#if MODBUS_MASTER_SLAVE_NUM
+	if ((slave == 0) || (slave > MODBUS_MASTER_SLAVE_NUM))
 	{
-		return MODBUS_ERR_INTFS;
+		return NULL;
 	}
 
-	return MODBUS_ERR_OK;
+	return &mb->slaves[slave - 1];
+#else
+	return NULL;
+#endif
 }
 
-/*Prepares packet and send it*/
-MBerror SiMasterPDUSend(mb_master_t *mb, uint8_t slave, uint8_t func, uint32_t len)
+/*Returns response timeout allowance for request and response data length, ms*/
+static uint32_t SiMasterLenTime(const SiMasterReq_t *req)
 {
-	mb->tx_buf[0] = slave; //slave address
-	mb->tx_buf[1] = func;  //function code
+	switch (req->func)
+	{
+		case MODBUS_FUNC_RDCOIL:
+		case MODBUS_FUNC_RDDINP:
+		case MODBUS_FUNC_WRMCOILS:
+			return (req->num + 7U) / 8;
+
+		case MODBUS_FUNC_RDHLDREGS:
+		case MODBUS_FUNC_RDINREGS:
+		case MODBUS_FUNC_WRMREGS:
+			return 2U * req->num;
+
+		case MODBUS_FUNC_RDWRMREGS:
+			return 2U * req->num + 2U * req->wr_num;
 
-	uint16_t crc = ModRTU_CRC(mb->tx_buf, len + 2); //CRC for all data
+		case MODBUS_FUNC_RDFILE:
+		case MODBUS_FUNC_WRFILE:
+			return SiMasterFileLen(req, 0);
 
-	U162ARR(crc, (uint8_t *) &mb->tx_buf[2] + len);
+		default:
+			return 0;
+	}
+}
 
-	return mb->itfs_write(mb->tx_buf, len + 2 + 2);
+/*Checks that normal response of function has byte count field (read functions)*/
+static uint8_t SiMasterHasByteCount(uint8_t func)
+{
+	return (func == MODBUS_FUNC_RDCOIL) || (func == MODBUS_FUNC_RDDINP) || (func == MODBUS_FUNC_RDHLDREGS) ||
+		   (func == MODBUS_FUNC_RDINREGS) || (func == MODBUS_FUNC_RDWRMREGS) || (func == MODBUS_FUNC_RDFILE);
 }
 
-/*Check is it exception in response*/
-MBerror SiMasterCheckException(mb_master_t *mb)
+/*Returns PDU length of file records request or response with sub_len header bytes per sub-request*/
+static uint16_t SiMasterFileLen(const SiMasterReq_t *req, uint16_t sub_len)
 {
-	if (mb->rx_buf[1] & 0x80)
+	uint32_t len = 2;
+	uint16_t i;
+
+	for (i = 0; i < req->num; i++)
 	{
-		/*Check CRC*/
-		if (ModRTU_CRC(mb->rx_buf, 3) == ARR2U16(&mb->rx_buf[3]))
-		{
-			return mb->rx_buf[2]; //exception code
-		}
-		else
-		{
-			return MODBUS_ERR_CRC;
-		}
+		len += sub_len + 2U * req->recs[i].num;
 	}
 
-	return MODBUS_ERR_OK;
+	return (len > 0xFFFF) ? 0xFFFF : (uint16_t) len;
+}
+
+/*Fills request of blocking call*/
+static void SiMasterReqFill(SiMasterReq_t *req, uint8_t slave, uint8_t func, uint16_t addr, uint16_t num)
+{
+	memset(req, 0, sizeof(*req));
+
+	req->slave = slave;
+	req->func = func;
+	req->addr = addr;
+	req->num = num;
+	req->prio = SIMASTER_PRIO_URGENT;
 }
 
-MBerror SiMasterWaitForResponse(mb_master_t *mb, uint32_t timeout)
+#if MODBUS_MASTER_RX_STAGED
+/*Returns length of the rest of frame after header*/
+static uint32_t SiMasterRxRest(mb_master_t *mb)
 {
-	return mb->wait_for_resp(timeout);
+	uint8_t *rx = mb->rx_buf;
+	uint32_t rest = mb->rx_wait_len - SIMASTER_HDR_LEN;
+
+	if (rx[1] & 0x80)
+	{
+		/*Exception: CRC only*/
+		return 2;
+	}
+
+	if (SiMasterHasByteCount(rx[1]) && (rx[2] + 2U < rest))
+	{
+		/*Short byte count: frame ends earlier than expected*/
+		return rx[2] + 2U;
+	}
+
+	return rest;
 }
+#endif
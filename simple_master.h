@@ -10,22 +10,129 @@
 #define SIMPLE_MASTER_H_
 
 #include "modbus_conf.h"
+#include "mb_pdu.h"
+
+/**
+ * @brief Request priority lanes. Next free bus slot goes to the highest priority request
+ */
+#define SIMASTER_PRIO_URGENT	0	/*Urgent writes (commands)*/
+#define SIMASTER_PRIO_CONTROL	1	/*Control loop reads*/
+#define SIMASTER_PRIO_SCAN		2	/*Background scans*/
+#define SIMASTER_PRIO_NUM		3
+
+typedef struct SiMasterReq_s SiMasterReq_t;
+
+/**
+ * @brief File record sub-request of FC20/FC21
+ */
+typedef struct {
+	uint16_t file;					/*!< File number */
+	uint16_t record;				/*!< Starting record number (0 - 9999) */
+	uint16_t num;					/*!< Record length, registers */
+	uint16_t *val;					/*!< Record data read storage or values to write */
+} SiMasterFileRec_t;
+
+/**
+ * @brief Request completion callback. Called from SiMasterPoll() or, for requests
+ *        completed on start (broadcast, quarantined slave, Tx error), from
+ *        SiMasterSubmit() before it returns
+ */
+typedef void (*SiMasterCb_t)(MBerror err, const SiMasterReq_t *req);
+
+/**
+ * @brief Master request
+ */
+struct SiMasterReq_s {
+	SiMasterReq_t *next;			/*!< Queue link (internal) */
+	uint8_t slave;					/*!< Slave address, 0 for broadcast write */
+	uint8_t func;					/*!< Function code */
+	uint16_t addr;					/*!< First register/coil address (read address of FC23) */
+	uint16_t num;					/*!< Registers/coils number (read number of FC23) */
+	uint16_t *val;					/*!< Registers read storage or values to write. Must be valid until completion */
+	uint8_t *bits;					/*!< Packed coils/inputs (first in LSB of first byte) read storage or values to write */
+	uint16_t wr_addr;				/*!< FC23 first register to write */
+	uint16_t wr_num;				/*!< FC23 registers number to write */
+	uint16_t *wr_val;				/*!< FC23 values to write */
+	SiMasterFileRec_t *recs;		/*!< FC20/FC21 sub-requests, num is sub-requests number */
+	SiMasterCb_t cb;				/*!< Completion callback (optional) */
+	void *arg;						/*!< User argument */
+	uint8_t prio;					/*!< Priority lane SIMASTER_PRIO_x */
+	uint8_t tries;					/*!< Retries done (internal) */
+};
+
+/**
+ * @brief Slave link state, indexed by slave address. Response time is tracked as
+ *        smoothed value and mean deviation (fixed point, 1/8 and 1/4 ms)
+ */
+typedef struct {
+	uint32_t probe_tick;			/*!< Last probe tick of quarantined slave */
+	uint16_t srtt;					/*!< Smoothed response time, 1/8 ms */
+	uint16_t rttvar;				/*!< Response time deviation, 1/4 ms */
+	uint8_t fails;					/*!< Failed requests in a row */
+	uint8_t offline;				/*!< Slave is quarantined */
+} SiMasterSlave_t;
 
 typedef struct {
 	MBerror (*itfs_write)(uint8_t *data, uint32_t len);
 	MBerror (*itfs_read)(uint32_t len);
-	MBerror (*wait_for_resp)(uint32_t timeout);
+	MBerror (*wait_for_resp)(uint32_t timeout);		/*!< Blocking calls only */
+	void (*itfs_abort)(void);						/*!< Stops reception on timeout (optional) */
 	uint8_t *rx_buf;
 	uint8_t *rx_byte;
 	uint8_t *tx_buf;
 	uint8_t mb_slave;
 	uint32_t rx_len;
 	uint32_t rx_wait_len;
+	volatile uint8_t rx_done;						/*!< Reception has been completed */
+#if MODBUS_MASTER_RX_STAGED
+	uint8_t rx_stage;								/*!< 1: header reception, 2: rest of frame */
+#endif
+	SiMasterReq_t *cur;								/*!< Request in progress */
+	SiMasterReq_t *head[SIMASTER_PRIO_NUM];			/*!< Pending requests queues */
+	SiMasterReq_t *tail[SIMASTER_PRIO_NUM];
+	uint32_t start_tick;
+	uint32_t rx_tick;								/*!< Reception complete tick */
+	uint32_t timeout;
+	uint32_t retry_tick;							/*!< Retry start tick */
+	uint8_t retry;									/*!< Current request waits for retry */
+#if MODBUS_MASTER_SLAVE_NUM
+	SiMasterSlave_t slaves[MODBUS_MASTER_SLAVE_NUM];	/*!< State of slaves 1 - MODBUS_MASTER_SLAVE_NUM */
+#endif
 } mb_master_t;
 
+/**
+ * @brief Registers range of read request
+ */
+typedef struct {
+	uint16_t addr;
+	uint16_t num;
+} SiMasterRange_t;
+
 MBerror SiMasterInit(mb_master_t *mb);
+MBerror SiMasterReadCoils(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits);
+MBerror SiMasterReadDInputs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits);
 MBerror SiMasterReadHRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val);
+MBerror SiMasterReadIRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val);
+MBerror SiMasterWriteCoil(mb_master_t *mb, uint8_t slave, uint16_t addr, uint8_t val);
 MBerror SiMasterWriteReg(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t val);
+MBerror SiMasterWriteMCoils(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint8_t *bits);
 MBerror SiMasterWriteMRegs(mb_master_t *mb, uint8_t slave, uint16_t addr, uint16_t num, uint16_t *val);
+MBerror SiMasterReadWriteRegs(mb_master_t *mb, uint8_t slave, uint16_t rd_addr, uint16_t rd_num, uint16_t *rd_val,
+							  uint16_t wr_addr, uint16_t wr_num, uint16_t *wr_val);
+MBerror SiMasterReadFile(mb_master_t *mb, uint8_t slave, SiMasterFileRec_t *recs, uint16_t num);
+MBerror SiMasterWriteFile(mb_master_t *mb, uint8_t slave, SiMasterFileRec_t *recs, uint16_t num);
+MBerror SiMasterPlanReads(const uint16_t *addr, uint16_t num, const uint32_t *rd_map, uint16_t gap,
+						  SiMasterRange_t *plan, uint16_t *plan_num);
+
+MBerror SiMasterSubmit(mb_master_t *mb, const SiMasterReq_t *req);
+void SiMasterRxCmplt(mb_master_t *mb, uint32_t len);
+void SiMasterPoll(mb_master_t *mb);
+uint8_t SiMasterIdle(const mb_master_t *mb);
+void SiMasterSlaveReset(mb_master_t *mb, uint8_t slave);
+
+MBerror SiMasterCheckReq(const SiMasterReq_t *req);
+uint16_t SiMasterPDUBuild(const SiMasterReq_t *req, uint8_t *pdu);
+uint16_t SiMasterPDURespLen(const SiMasterReq_t *req);
+MBerror SiMasterPDUParse(const SiMasterReq_t *req, const uint8_t *pdu, uint16_t len);
 
 #endif
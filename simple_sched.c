@@ -0,0 +1,196 @@
+/*
+ * simple_sched.c
+ *
+ * Periodic polling scheduler of master. Each time the bus is free the
+ * released poll group with the earliest deadline is read, so the bus is
+ * loaded evenly and short periods are served first.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#include "simple_sched.h"
+#include <string.h>
+
+static void SiSchedReq(SiSchedGroup_t *g, SiMasterReq_t *req);
+static void SiSchedDone(MBerror err, const SiMasterReq_t *req);
+static void SiSchedOverrun(SiSchedGroup_t *g, uint32_t num);
+
+/**
+ * @brief       Initializes scheduler. Scheduler fields and poll groups must be filled.
+ *              First reads of all groups are released immediately.
+ * @param s     Scheduler
+ * @return      Error code. MODBUS_ERR_VALUE if a group is incorrect or
+ *              bus time of all groups exceeds bus capacity (s->load > 1000).
+ */
+MBerror SiSchedInit(SiSched_t *s)
+{
+	uint8_t pdu[8];
+	SiMasterReq_t req;
+	SiSchedGroup_t *g;
+	uint32_t now = MODBUS_GET_TICK;
+	uint16_t len;
+	uint16_t i;
+
+	if ((s->mb == NULL) || (s->baud == 0) || ((s->groups == NULL) && (s->groups_num > 0)))
+	{
+		return MODBUS_ERR_MASTER;
+	}
+
+	s->load = 0;
+
+	for (i = 0; i < s->groups_num; i++)
+	{
+		g = &s->groups[i];
+		SiSchedReq(g, &req);
+
+		if ((g->func < MODBUS_FUNC_RDCOIL) || (g->func > MODBUS_FUNC_RDINREGS) || (g->slave == 0) || (g->period == 0) ||
+			((len = SiMasterPDUBuild(&req, pdu)) == 0))
+		{
+			return MODBUS_ERR_VALUE;
+		}
+
+		g->sched = s;
+		g->ready = 0;
+		g->busy = 0;
+		g->err = MODBUS_ERR_OK;
+		g->release = now;
+		g->deadline = now + g->period;
+		g->done_tick = now;
+		g->overruns = 0;
+		g->bus_time = SiSchedBusTime(s->baud, len + 3, SiMasterPDURespLen(&req) + 3) + s->turnaround;
+
+		/*bus time (us) per period (ms) is load in 1/1000*/
+		s->load += (g->bus_time + g->period - 1) / g->period;
+	}
+
+	return (s->load <= 1000) ? MODBUS_ERR_OK : MODBUS_ERR_VALUE;
+}
+
+/**
+ * @brief       Drives master and starts the read with the earliest deadline when
+ *              master queue is empty. Call it periodically instead of SiMasterPoll().
+ * @param s     Scheduler
+ */
+void SiSchedPoll(SiSched_t *s)
+{
+	SiSchedGroup_t *g, *next = NULL;
+	SiMasterReq_t req;
+	uint32_t now, missed;
+	uint16_t i;
+
+	SiMasterPoll(s->mb);
+
+	now = MODBUS_GET_TICK;
+
+	for (i = 0; i < s->groups_num; i++)
+	{
+		g = &s->groups[i];
+
+		if (g->busy || ((int32_t) (now - g->release) < 0))
+		{
+			continue;
+		}
+
+		if ((int32_t) (now - g->deadline) >= 0)
+		{
+			/*Period has passed without read, skip to the current one*/
+			missed = (now - g->release) / g->period;
+			g->release += missed * g->period;
+			g->deadline = g->release + g->period;
+			SiSchedOverrun(g, missed);
+		}
+
+		g->ready = 1;
+
+		if ((next == NULL) || ((int32_t) (g->deadline - next->deadline) < 0) ||
+			((g->deadline == next->deadline) && (g->prio < next->prio)))
+		{
+			next = g;
+		}
+	}
+
+	/*Decision is made at each free bus slot, other requests have been queued first*/
+	if ((next == NULL) || !SiMasterIdle(s->mb))
+	{
+		return;
+	}
+
+	/*Callback may be called from SiMasterSubmit(), so group is marked busy first*/
+	SiSchedReq(next, &req);
+	next->ready = 0;
+	next->busy = 1;
+
+	if (SiMasterSubmit(s->mb, &req) != MODBUS_ERR_OK)
+	{
+		/*No free requests in pool, try later*/
+		next->ready = 1;
+		next->busy = 0;
+	}
+}
+
+/**
+ * @brief           Returns bus time of RTU transaction
+ * @param baud      Baud rate
+ * @param req_len   Request frame length
+ * @param resp_len  Response frame length
+ * @return          Bus time, us
+ */
+uint32_t SiSchedBusTime(uint32_t baud, uint16_t req_len, uint16_t resp_len)
+{
+	/*11 bits per character, 3.5 characters silent interval is fixed above 19200 baud*/
+	uint32_t char_time = (11000000UL + baud - 1) / baud;
+	uint32_t gap = (baud > 19200) ? 1750 : (35 * char_time + 9) / 10;
+
+	return (uint32_t) (req_len + resp_len) * char_time + 2 * gap;
+}
+
+/*Fills read request of poll group*/
+static void SiSchedReq(SiSchedGroup_t *g, SiMasterReq_t *req)
+{
+	memset(req, 0, sizeof(*req));
+
+	req->slave = g->slave;
+	req->func = g->func;
+	req->addr = g->addr;
+	req->num = g->num;
+	req->val = g->val;
+	req->bits = g->bits;
+	req->cb = SiSchedDone;
+	req->arg = g;
+	req->prio = SIMASTER_PRIO_SCAN;
+}
+
+/*Read completion callback*/
+static void SiSchedDone(MBerror err, const SiMasterReq_t *req)
+{
+	SiSchedGroup_t *g = (SiSchedGroup_t *) req->arg;
+	SiSched_t *s = g->sched;
+
+	g->busy = 0;
+	g->err = err;
+	g->done_tick = MODBUS_GET_TICK;
+
+	if ((int32_t) (g->done_tick - g->deadline) > 0)
+	{
+		SiSchedOverrun(g, 1);
+	}
+
+	g->release += g->period;
+	g->deadline += g->period;
+
+	if (s->done)
+	{
+		s->done(g);
+	}
+}
+
+/*Counts and reports missed deadlines*/
+static void SiSchedOverrun(SiSchedGroup_t *g, uint32_t num)
+{
+	g->overruns += num;
+
+	if (g->sched->overrun)
+	{
+		g->sched->overrun(g);
+	}
+}
@@ -0,0 +1,57 @@
+/*
+ * simple_sched.h
+ *
+ * Periodic polling scheduler of master. Poll groups are read
+ * earliest-deadline-first when the bus is free.
+ *
+ *  Created on: 19.10.2026
+ */
+
+#ifndef SIMPLE_SCHED_H_
+#define SIMPLE_SCHED_H_
+
+#include "simple_master.h"
+
+typedef struct SiSched_s SiSched_t;
+
+/**
+ * @brief Poll group: registers range read with the period.
+ *        Deadline of each read is the next period start.
+ */
+typedef struct {
+	uint8_t slave;					/*!< Slave address */
+	uint8_t func;					/*!< Read function code (FC1 - FC4) */
+	uint16_t addr;					/*!< First register/coil address */
+	uint16_t num;					/*!< Registers/coils number */
+	uint16_t *val;					/*!< Registers values storage */
+	uint8_t *bits;					/*!< Packed coils/inputs storage */
+	uint32_t period;				/*!< Poll period, ms */
+	uint8_t prio;					/*!< Priority of groups with the same deadline, 0 is the highest */
+	/*Scheduler state*/
+	SiSched_t *sched;
+	uint8_t ready;					/*!< Read of current period is waiting for the bus */
+	uint8_t busy;					/*!< Read is queued or in progress */
+	MBerror err;					/*!< Last read result */
+	uint32_t release;				/*!< Current period start tick */
+	uint32_t deadline;				/*!< Current period deadline tick */
+	uint32_t done_tick;				/*!< Last read completion tick */
+	uint32_t bus_time;				/*!< Bus time of read transaction, us */
+	uint32_t overruns;				/*!< Missed deadlines counter */
+} SiSchedGroup_t;
+
+struct SiSched_s {
+	mb_master_t *mb;				/*!< Master handle */
+	uint32_t baud;					/*!< Bus baud rate */
+	uint32_t turnaround;			/*!< Slave response delay, us */
+	SiSchedGroup_t *groups;			/*!< Poll groups array */
+	uint16_t groups_num;			/*!< Poll groups number */
+	void (*done)(SiSchedGroup_t *g);		/*!< Read completion callback (optional) */
+	void (*overrun)(SiSchedGroup_t *g);		/*!< Deadline miss callback (optional) */
+	uint32_t load;					/*!< Bus load of all groups, 1/1000 */
+};
+
+MBerror SiSchedInit(SiSched_t *s);
+void SiSchedPoll(SiSched_t *s);
+uint32_t SiSchedBusTime(uint32_t baud, uint16_t req_len, uint16_t resp_len);
+
+#endif /* SIMPLE_SCHED_H_ */